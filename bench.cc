@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "candidates.hh"
+#include "database.hh"
+#include "greedy.hh"
+#include "knapsack.hh"
+#include "lineup.hh"
+#include "options.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * Benchmark of the solvers: runs each solver on every query of the benchmark directory, for the database given and
+ * for a scaled-up copy of it, several times (and with several seeds the metaheuristic), and reports for each solver
+ * and query the median and p95 latency, the runs that found the optimal team and the median time until they found
+ * it, the gap of the points to the optimal ones, and the peak memory.
+ *
+ * The solvers are run as separate processes, so their times and memory are measured as in a normal run, and
+ * each one writes its statistics with --stats (see stats.hh), where the time to the optimal team is taken from.
+ * The optimal points of each query are computed here with the knapsack algorithm.
+ */
+
+
+PlayerTable player_table; // players of the databases, added by the pools of candidates
+Query query; // not used: each query is solved for its own query
+
+
+// Result of a run of a solver
+struct Run
+{
+    double ms; // wall time of the process
+    int points; // of the team written, 0 if there is none
+    double ms_to_optimal; // time when the optimal team was found, or -1
+    long peak_rss_kb;
+};
+
+
+// Solver to benchmark: a program and the arguments added to its runs, shown in the report by its name
+struct Solver
+{
+    string name, program;
+    vector<string> args;
+};
+
+
+// Row of the report: the runs of a solver on a query
+struct Row
+{
+    string database, instance, solver;
+    int optimal_points;
+    vector<Run> runs;
+};
+
+
+// Options of the benchmark
+string bin_dir = ".";
+string work_dir = (filesystem::temp_directory_path() / "fantasy_bench").string();
+vector<Solver> solvers = {{"dp", "dp", {}}, {"greedy", "greedy", {}}, {"exh", "exh", {}}, {"mh", "mh", {}}};
+uint repetitions = 3;
+uint num_seeds = 3; // seeds of the solvers with random numbers (1, 2, ...)
+int deadline_ms = 0; // deadline given to exh and mh, 0 for no deadline
+uint scale = 100; // the scaled-up database has the players of the database this number of times, 0 for none
+
+
+// Splits a list separated by a character
+vector<string> split(const string& list, char separator = ',') {
+    vector<string> items;
+    stringstream input(list);
+    string item;
+    while (getline(input, item, separator)) {
+        if (not item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+
+// Reads the solvers of a list separated by commas: each one is a program ("greedy"), or a name followed by the
+// program and its arguments separated by spaces ("greedy-sweep=greedy --alphas 8 --restarts 4")
+vector<Solver> read_solvers(const string& list) {
+    vector<Solver> solvers;
+    for (const string& item : split(list)) {
+        size_t equal = item.find('=');
+        if (equal == string::npos) {
+            solvers.push_back({item, item, {}});
+            continue;
+        }
+        vector<string> words = split(item.substr(equal + 1), ' ');
+        if (words.empty()) {
+            cerr << "The solver " << item << " has no program" << endl;
+            exit(1);
+        }
+        solvers.push_back({item.substr(0, equal), words[0], vector<string>(words.begin() + 1, words.end())});
+    }
+    return solvers;
+}
+
+
+// Returns true if the runs of a solver depend on a seed: the metaheuristic, and the greedy with randomized restarts
+bool uses_seed(const Solver& solver) {
+    return solver.program == "mh" or (solver.program == "greedy" and count(solver.args.begin(), solver.args.end(), "--restarts") > 0);
+}
+
+
+/*
+ * Writes a database with the players of another one repeated scale times. The copies get a suffix in their name and
+ * their price and points changed by up to 10% (always in the same way), so they aren't all dominated by the
+ * original ones and the queries have more candidates.
+ */
+void write_scaled_database(const Database& database, uint scale, const string& path) {
+    ofstream output(path);
+    uint i = 0;
+    database.for_each([&](const PlayerRecord& player) {
+        for (uint copy = 0; copy < scale; copy++, i++) {
+            int price = player.price, points = player.points;
+            if (copy > 0) {
+                price = int(llround(price * (1 + (int(i * 7919 % 21) - 10) / 100.0)) / 100000 * 100000);
+                points = int(llround(points * (1 + (int(i * 104729 % 21) - 10) / 100.0)));
+            }
+            output << player.name << (copy > 0 ? "_" + to_string(copy) : "") << ";" << player.position << ";"
+                   << price << ";" << player.club << ";" << points << "\n";
+        }
+    });
+}
+
+
+// Returns the optimal points of a query
+int optimal_points(CandidatePool& pool, const Query& query) {
+    return knapsack_lineup(query, pool.get_candidates(query)).get_points();
+}
+
+
+// Returns the points of an output file, or 0 if it has no team
+int read_points(const string& output_file) {
+    ifstream input(output_file);
+    string word;
+    while (input >> word) {
+        if (word == "Punts:" and input >> word) return stoi(word);
+    }
+    return 0;
+}
+
+
+// Returns the time when a run found a team with the optimal points, from the statistics of the run, or -1
+double read_ms_to_optimal(const string& stats_file, int optimal) {
+    ifstream input(stats_file);
+    string line;
+    getline(input, line);
+    size_t start = line.find("\"improvements\"");
+    while (start != string::npos and (start = line.find("{\"ms\": ", start)) != string::npos) {
+        double ms;
+        int points;
+        if (sscanf(line.c_str() + start, "{\"ms\": %lf, \"points\": %d}", &ms, &points) != 2) break;
+        if (points >= optimal) return ms;
+        start++;
+    }
+    return -1;
+}
+
+
+// Runs a program with the given arguments (the first one is the program) and waits for it
+Run run_process(const vector<string>& args) {
+    vector<char*> argv;
+    for (const string& arg : args) argv.push_back((char*) arg.c_str());
+    argv.push_back(nullptr);
+
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+        cerr << "The run of " << args[0] << " on " << args[2] << " failed" << endl;
+    }
+
+    Run run;
+    run.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    run.peak_rss_kb = usage.ru_maxrss;
+    return run;
+}
+
+
+// Runs a solver on a query, with a seed if it uses random numbers
+Run run_solver(const Solver& solver, const string& database, const string& query_file, int optimal, uint seed) {
+    string output_file = work_dir + "/output.txt", stats_file = work_dir + "/stats.jsonl";
+    filesystem::remove(output_file);
+
+    vector<string> args = {bin_dir + "/" + solver.program, database, query_file, output_file, "--stats", stats_file};
+    args.insert(args.end(), solver.args.begin(), solver.args.end());
+    if (uses_seed(solver)) args.insert(args.end(), {"--seed", to_string(seed)});
+    if ((solver.program == "exh" or solver.program == "mh") and deadline_ms > 0) args.insert(args.end(), {"--deadline-ms", to_string(deadline_ms)});
+
+    Run run = run_process(args);
+    run.points = read_points(output_file);
+    run.ms_to_optimal = read_ms_to_optimal(stats_file, optimal);
+    return run;
+}
+
+
+// Returns the p-th percentile (nearest rank) of some values, or -1 if there are none
+double percentile(vector<double> values, double p) {
+    if (values.empty()) return -1;
+    sort(values.begin(), values.end());
+    uint rank = max(1.0, ceil(p / 100 * values.size()));
+    return values[rank - 1];
+}
+
+
+// Benchmarks all the solvers on all the queries with a database, adding a row to rows for each solver and query
+void bench_database(const string& database_file, const string& name, const vector<string>& query_files, vector<Row>& rows) {
+    Database database(database_file);
+    CandidatePool pool(database);
+
+    for (const string& query_file : query_files) {
+        Query query = read_query(query_file);
+        int optimal = optimal_points(pool, query);
+
+        for (const Solver& solver : solvers) {
+            Row row = {name, filesystem::path(query_file).stem().string(), solver.name, optimal, {}};
+            uint seeds = uses_seed(solver) ? num_seeds : 1;
+            for (uint seed = 1; seed <= seeds; seed++) {
+                for (uint r = 0; r < repetitions; r++) row.runs.push_back(run_solver(solver, database_file, query_file, optimal, seed));
+            }
+            cerr << name << " " << row.instance << " " << solver.name << ": " << row.runs.size() << " runs" << endl;
+            rows.push_back(row);
+        }
+    }
+}
+
+
+/*
+ * Micro-benchmark of the heuristic keys of the greedy (greedy.hh) on all the players with points of a database:
+ * the time per alpha of computing the keys with GreedyKeys, against computing the value pow(points, alpha + 1) / price
+ * of each player as the greedy did before, and the time of computing the logarithms once. The alphas are the ones
+ * of a sweep around 1 (the alpha of a maximum cost of 10 million), and each one is repeated during about half a second.
+ */
+void bench_keys(const string& database_file, uint num_alphas) {
+    Database database(database_file);
+    PlayerList players;
+    database.for_each([&players](const PlayerRecord& player) {
+        if (player.points > 0) players.push_back(player_table.add(player.name, to_position(player.position), player.price, player.points));
+    });
+
+    auto time_per_alpha = [num_alphas](auto compute) {
+        auto start = chrono::steady_clock::now();
+        uint runs = 0;
+        do {
+            for (uint a = 0; a < num_alphas; a++) compute(2.0 * (a + 1) / (num_alphas + 1));
+            runs += num_alphas;
+        } while (chrono::steady_clock::now() - start < chrono::milliseconds(500));
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / runs;
+    };
+
+    double checksum = 0; // so the values aren't optimized away
+    vector<double> values(players.size());
+    double pow_us = time_per_alpha([&](double alpha) {
+        for (size_t i = 0; i < players.size(); i++) {
+            int price = player_table.price(players[i]);
+            values[i] = price == 0 ? 0 : pow(player_table.points(players[i]), alpha + 1) / price;
+        }
+        checksum += values[0];
+    });
+
+    vector<float> keys;
+    auto start = chrono::steady_clock::now();
+    GreedyKeys greedy_keys(players);
+    double logs_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    double keys_us = time_per_alpha([&](double alpha) {
+        greedy_keys.compute(alpha, keys);
+        checksum += keys[0];
+    });
+
+    cout << "players,pow_us_per_alpha,keys_us_per_alpha,logs_us" << endl;
+    cout << players.size() << "," << fixed << setprecision(2) << pow_us << "," << keys_us << "," << logs_us << endl;
+    cerr << "Checksum: " << checksum << endl;
+}
+
+
+// Writes the report, a line (or object) for each row
+void write_report(const vector<Row>& rows, const string& format) {
+    const vector<string> columns = {"database", "instance", "solver", "runs", "median_ms", "p95_ms", "optimal_runs",
+                                    "median_ms_to_optimal", "mean_gap_pct", "max_gap_pct", "peak_rss_kb"};
+    if (format == "csv") {
+        for (uint c = 0; c < columns.size(); c++) cout << (c > 0 ? "," : "") << columns[c];
+        cout << endl;
+    }
+    else {
+        cout << "[" << endl;
+    }
+
+    for (uint i = 0; i < rows.size(); i++) {
+        const Row& row = rows[i];
+        vector<double> ms, ms_to_optimal;
+        double sum_gap = 0, max_gap = 0;
+        long peak_rss = 0;
+        for (const Run& run : row.runs) {
+            ms.push_back(run.ms);
+            if (run.ms_to_optimal >= 0) ms_to_optimal.push_back(run.ms_to_optimal);
+            double gap = 100.0 * (row.optimal_points - run.points) / max(row.optimal_points, 1);
+            sum_gap += gap;
+            max_gap = max(max_gap, gap);
+            peak_rss = max(peak_rss, run.peak_rss_kb);
+        }
+
+        ostringstream values[11];
+        values[0] << row.database;
+        values[1] << row.instance;
+        values[2] << row.solver;
+        values[3] << row.runs.size();
+        values[4] << fixed << setprecision(2) << percentile(ms, 50);
+        values[5] << fixed << setprecision(2) << percentile(ms, 95);
+        values[6] << ms_to_optimal.size();
+        values[7] << fixed << setprecision(2) << percentile(ms_to_optimal, 50);
+        values[8] << fixed << setprecision(3) << sum_gap / row.runs.size();
+        values[9] << fixed << setprecision(3) << max_gap;
+        values[10] << peak_rss;
+
+        if (format == "csv") {
+            for (uint c = 0; c < columns.size(); c++) cout << (c > 0 ? "," : "") << values[c].str();
+            cout << endl;
+        }
+        else {
+            cout << "  {";
+            for (uint c = 0; c < columns.size(); c++) {
+                bool text = c < 3;
+                cout << (c > 0 ? ", " : "") << "\"" << columns[c] << "\": " << (text ? "\"" : "") << values[c].str() << (text ? "\"" : "");
+            }
+            cout << "}" << (i + 1 < rows.size() ? "," : "") << endl;
+        }
+    }
+    if (format != "csv") cout << "]" << endl;
+}
+
+
+/*
+ * bench <database> [--benchs <dir>] [--solvers <list>] [--repetitions <N>] [--seeds <N>] [--scale <N>]
+ *       [--deadline-ms <ms>] [--bin-dir <dir>] [--work-dir <dir>] [--format csv|json]
+ * bench <database> --micro keys [--scale <N>] [--alphas <N>]: micro-benchmark of the keys of the greedy on the
+ *       database scaled up (see bench_keys), with the alphas of a sweep of N alphas (16 by default)
+ * The solvers (dp, greedy, exh and mh by default, separated by commas) must be compiled in bin-dir. A solver can
+ * be given a name and arguments, for example --solvers "greedy,greedy-sweep=greedy --alphas 8 --restarts 4,mh"
+ * to compare the greedy sweep with the metaheuristic.
+ * The report is written in the standard output, and the progress in the standard error.
+ * A median_ms_to_optimal of -1 means that no run found the optimal team.
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        cerr << "Syntax: " << argv[0] << " data_base.txt [--benchs dir] [--solvers dp,greedy,exh,mh] [--repetitions N] "
+             << "[--seeds N] [--scale N] [--deadline-ms ms] [--bin-dir dir] [--work-dir dir] [--format csv|json]" << endl;
+        cerr << "       " << argv[0] << " data_base.txt --micro keys [--scale N] [--alphas N]" << endl;
+        exit(1);
+    }
+
+    map<string, string> options = read_options(argc, argv, 2, {"benchs", "solvers", "repetitions", "seeds", "scale",
+                                                               "deadline-ms", "bin-dir", "work-dir", "format", "micro", "alphas"});
+    string benchs_dir = options.count("benchs") ? options["benchs"] : "new_benchs";
+    if (options.count("solvers")) solvers = read_solvers(options["solvers"]);
+    if (options.count("repetitions")) repetitions = max(1, stoi(options["repetitions"]));
+    if (options.count("seeds")) num_seeds = max(1, stoi(options["seeds"]));
+    if (options.count("scale")) scale = max(0, stoi(options["scale"]));
+    if (options.count("deadline-ms")) deadline_ms = stoi(options["deadline-ms"]);
+    if (options.count("bin-dir")) bin_dir = options["bin-dir"];
+    if (options.count("work-dir")) work_dir = options["work-dir"];
+    string format = options.count("format") ? options["format"] : "csv";
+
+    if (options.count("micro")) {
+        if (options["micro"] != "keys") {
+            cerr << "Unknown micro-benchmark: " << options["micro"] << endl;
+            exit(1);
+        }
+        filesystem::create_directories(work_dir);
+        string database_file = argv[1];
+        if (scale > 1) {
+            database_file = work_dir + "/scaled_x" + to_string(scale) + ".txt";
+            Database database(argv[1]);
+            write_scaled_database(database, scale, database_file);
+        }
+        bench_keys(database_file, options.count("alphas") ? max(1, stoi(options["alphas"])) : 16);
+        return 0;
+    }
+
+    for (const Solver& solver : solvers) {
+        if (access((bin_dir + "/" + solver.program).c_str(), X_OK) != 0) {
+            cerr << "Can't find the solver " << bin_dir << "/" << solver.program << ", compile it with: g++ " << solver.program
+                 << ".cc -o " << solver.program << " -std=c++17 -O3 -Wall -pthread" << endl;
+            exit(1);
+        }
+    }
+    filesystem::create_directories(work_dir);
+
+    vector<string> query_files;
+    for (const auto& entry : filesystem::directory_iterator(benchs_dir)) {
+        if (entry.path().extension() == ".txt") query_files.push_back(entry.path().string());
+    }
+    sort(query_files.begin(), query_files.end());
+
+    vector<Row> rows;
+    bench_database(argv[1], filesystem::path(argv[1]).filename().string(), query_files, rows);
+    if (scale > 1) {
+        string scaled_file = work_dir + "/scaled_x" + to_string(scale) + ".txt";
+        {
+            Database database(argv[1]);
+            write_scaled_database(database, scale, scaled_file);
+        }
+        bench_database(scaled_file, "x" + to_string(scale), query_files, rows);
+    }
+
+    write_report(rows, format);
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dominance.hh"
+#include "options.hh"
+
+using namespace std;
+
+
+/*
+ * Micro-benchmark of the removal of dominated players (dominance.hh): times find_dominated on random players of
+ * one position, from 10 thousand to millions of them. The prices are multiples of 100000 up to 20 million and the
+ * points grow with the price plus some noise, as in the real database, so many players have the same price or the
+ * same points. For the smaller sizes the result is also compared with the quadratic filter that compares every pair
+ * of players, and its time is shown.
+ */
+
+
+// Returns the players dominated by k other players comparing every pair of them, O(n^2) as the count_if over
+// the list of the position that find_dominated replaced
+vector<bool> find_dominated_quadratic(const vector<int>& prices, const vector<int>& points, uint k) {
+    size_t n = prices.size();
+    vector<bool> dominated(n, false);
+    for (size_t i = 0; i < n; i++) {
+        uint count = 0;
+        for (size_t j = 0; j < n; j++) {
+            // the same order as find_dominated: cheaper, or as cheap with more points, or equal and before
+            bool before = prices[j] < prices[i] or (prices[j] == prices[i] and (points[j] > points[i] or (points[j] == points[i] and j < i)));
+            if (before and points[j] >= points[i]) count++;
+        }
+        dominated[i] = count >= k;
+    }
+    return dominated;
+}
+
+
+// Returns the milliseconds since a given time
+double ms_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+/*
+ * bench_dominance [--sizes <list>] [--k <K>] [--seed <S>] [--check-up-to <N>]
+ * sizes: numbers of players separated by commas (10000,100000,1000000 by default)
+ * k: maximum number of players of the position in a lineup (5 by default)
+ * check-up-to: the quadratic filter is only run for sizes up to N (20000 by default)
+ */
+int main(int argc, char *argv[]) {
+
+    map<string, string> options = read_options(argc, argv, 1, {"sizes", "k", "seed", "check-up-to"});
+    vector<size_t> sizes = {10000, 100000, 1000000};
+    if (options.count("sizes")) {
+        sizes.clear();
+        string list = options["sizes"];
+        for (size_t start = 0; start < list.size(); ) {
+            size_t end = list.find(',', start);
+            if (end == string::npos) end = list.size();
+            sizes.push_back(stoul(list.substr(start, end - start)));
+            start = end + 1;
+        }
+    }
+    uint k = options.count("k") ? stoul(options["k"]) : 5;
+    uint seed = options.count("seed") ? stoul(options["seed"]) : 1;
+    size_t check_up_to = options.count("check-up-to") ? stoul(options["check-up-to"]) : 20000;
+
+    cout << "players,k,dominated,sweep_ms,quadratic_ms,same" << endl;
+    for (size_t n : sizes) {
+        mt19937 gen(seed);
+        uniform_int_distribution<int> price_steps(0, 200);
+        normal_distribution<double> noise(0, 15);
+        vector<int> prices(n), points(n);
+        for (size_t i = 0; i < n; i++) {
+            prices[i] = price_steps(gen) * 100000;
+            points[i] = max(0, int(prices[i] / 150000 + noise(gen)));
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<bool> dominated = find_dominated(prices, points, k);
+        double sweep_ms = ms_since(start);
+
+        size_t num_dominated = 0;
+        for (bool d : dominated) num_dominated += d;
+
+        cout << n << "," << k << "," << num_dominated << "," << sweep_ms << ",";
+        if (n <= check_up_to) {
+            start = chrono::steady_clock::now();
+            vector<bool> expected = find_dominated_quadratic(prices, points, k);
+            double quadratic_ms = ms_since(start);
+            cout << quadratic_ms << "," << (dominated == expected ? "yes" : "no") << endl;
+        }
+        else {
+            cout << "," << endl;
+        }
+    }
+}
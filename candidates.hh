@@ -0,0 +1,187 @@
+#ifndef CANDIDATES_HH
+#define CANDIDATES_HH
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "database.hh"
+#include "dominance.hh"
+#include "lineup.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * Players of the database that can be picked by the queries. The database is read once, and the players of each
+ * position that can be picked for a maximum price per player (and a maximum number of players in the position)
+ * are computed once and shared by all the queries with the same values.
+ * A compiled database is only read up to the highest maximum price per player of the queries asked so far, so the
+ * players that are too expensive for all of them are never read (a text database is read at once, as all its lines
+ * must be parsed anyway).
+ * Only the players that are candidates of some query are added to the player table.
+ * The candidates can be asked from many threads, but they add the players that weren't candidates of any query before
+ * to the player table, so the table must not be read by other threads meanwhile. A player that is worse in points
+ * and price than 10 others of its position is never a candidate, whatever the maximum price, so the table stays
+ * small for databases of any size.
+ * The price and points of a player can be changed (see update), and then only the candidates of its position are
+ * computed again.
+ */
+class CandidatePool
+{
+public:
+    static constexpr PlayerId NONE = UINT16_MAX;
+
+private:
+    const Database& database;
+    int loaded_price = INT_MIN; // the records with price <= loaded_price have been read from the database
+    vector<PlayerRecord> records; // players of the database read, in the order they were read
+    vector<PlayerId> ids; // id in the player table of each record, or NONE if it hasn't been added
+    PerPosition<unordered_map<string_view, uint>> record_by_name; // first record of each position with each name
+    bool names_indexed = false; // if record_by_name has been built, it's only built when it's first needed
+    PerPosition<PlayerList> fakes; // fake players of each position (price and points 0)
+
+    map<int, PerPosition<vector<uint>>> affordable; // records of each position with price <= max price, by max price
+    map<tuple<int, Position, uint>, PlayerList> candidates; // candidates by max price, position and number of players
+    mutex candidates_mutex; // protects the maps of candidates
+
+public:
+
+    // The database must exist while the pool is used
+    CandidatePool(const Database& database) : database(database) {
+        if (not database.compiled()) load(INT_MAX);
+    }
+
+    /*
+     * Returns the players of each position to be considered for the query: the ones with price <= max price per player,
+     * except those that are worse in points and price than other players in the same position given the maximum number
+     * of players in each position, followed by as many fake players as players are needed in the position.
+     */
+    PlayerMap get_candidates(const Query& query) {
+        lock_guard<mutex> lock(candidates_mutex);
+        PlayerMap players_map;
+        for (Position pos : positions) {
+            players_map[pos] = get_candidates(query.max_price_per_player, pos, query.max_num_players[pos]);
+        }
+        return players_map;
+    }
+
+    // Returns the record of the player of the database with a position and a name (the first one if there are several),
+    // or nullptr. All the database is read, so the records don't move any more.
+    const PlayerRecord* find(Position pos, string_view name) {
+        lock_guard<mutex> lock(candidates_mutex);
+        load(INT_MAX);
+        if (not names_indexed) {
+            for (uint i = 0; i < records.size(); i++) record_by_name[to_position(records[i].position)].emplace(records[i].name, i);
+            names_indexed = true;
+        }
+        auto it = record_by_name[pos].find(name);
+        return it == record_by_name[pos].end() ? nullptr : &records[it->second];
+    }
+
+    // Returns the id in the player table of a record of the pool, adding it if needed
+    PlayerId id_of(const PlayerRecord& record) {
+        lock_guard<mutex> lock(candidates_mutex);
+        return get_id(&record - records.data());
+    }
+
+    /*
+     * Changes the price and points of a record of the pool (and of its player in the table, if it was added).
+     * The lists of affordable players of its position are updated, and its candidates are computed again when
+     * they are asked. The player table must not be read by other threads while it changes.
+     */
+    void update(const PlayerRecord& record, int price, int points) {
+        lock_guard<mutex> lock(candidates_mutex);
+        uint i = &record - records.data();
+        Position pos = to_position(record.position);
+
+        for (auto& [max_price, players] : affordable) {
+            vector<uint>& list = players[pos];
+            bool was_affordable = records[i].points > 0 and records[i].price <= max_price;
+            bool is_affordable = points > 0 and price <= max_price;
+            auto it = lower_bound(list.begin(), list.end(), i); // the lists are in the order of the records
+            if (was_affordable and not is_affordable) list.erase(it);
+            if (not was_affordable and is_affordable) list.insert(it, i);
+        }
+        for (auto it = candidates.begin(); it != candidates.end(); ) {
+            if (get<1>(it->first) == pos) it = candidates.erase(it);
+            else ++it;
+        }
+
+        records[i].price = price;
+        records[i].points = points;
+        if (ids[i] != NONE) player_table.update(ids[i], price, points);
+    }
+
+private:
+
+    // Reads the players of the database with price <= max_price that haven't been read yet
+    void load(int max_price) {
+        if (max_price <= loaded_price) return;
+        database.for_each([this](const PlayerRecord& player) { records.push_back(player); }, max_price, loaded_price);
+        ids.resize(records.size(), NONE);
+        loaded_price = max_price;
+    }
+
+    const PlayerList& get_candidates(int max_price, Position pos, uint num_players) {
+        auto key = make_tuple(max_price, pos, num_players);
+        auto it = candidates.find(key);
+        if (it != candidates.end()) return it->second;
+
+        const vector<uint>& players = get_affordable(max_price)[pos];
+        vector<int> prices, points;
+        for (uint i : players) {
+            prices.push_back(records[i].price);
+            points.push_back(records[i].points);
+        }
+        vector<bool> dominated = find_dominated(prices, points, num_players);
+
+        PlayerList list;
+        for (uint j = 0; j < players.size(); j++) {
+            if (not dominated[j]) list.push_back(get_id(players[j]));
+        }
+        for (uint i = 0; i < num_players; i++) list.push_back(get_fake(pos, i));
+
+        return candidates[key] = list;
+    }
+
+    // Returns the records with points of each position with price <= max_price, in the order they were read
+    // (the players without points, and the fake ones, are never needed)
+    const PerPosition<vector<uint>>& get_affordable(int max_price) {
+        auto it = affordable.find(max_price);
+        if (it != affordable.end()) return it->second;
+
+        load(max_price);
+        PerPosition<vector<uint>>& players = affordable[max_price];
+        for (uint i = 0; i < records.size(); i++) {
+            if (records[i].points > 0 and records[i].price <= max_price) players[to_position(records[i].position)].push_back(i);
+        }
+        return players;
+    }
+
+    // Returns the id of a record in the player table, adding it if needed
+    PlayerId get_id(uint record) {
+        if (ids[record] == NONE) {
+            const PlayerRecord& player = records[record];
+            ids[record] = player_table.add(player.name, to_position(player.position), player.price, player.points);
+        }
+        return ids[record];
+    }
+
+    // Returns the i-th fake player of a position, adding it if needed
+    PlayerId get_fake(Position pos, uint i) {
+        while (fakes[pos].size() <= i) {
+            fakes[pos].push_back(player_table.add("Fake_" + pos_name(pos) + to_string(fakes[pos].size() + 1), pos, 0, 0));
+        }
+        return fakes[pos][i];
+    }
+};
+
+#endif
@@ -2,7 +2,16 @@
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#include "database.hh"
+#include "lineup.hh"
+#include "options.hh"
 using namespace std;
 
 void check(bool cond, string msg) {
@@ -31,21 +40,8 @@ public:
   }
 };
 
-class Tactic {
-public:
-  uint goal;
-  uint def;
-  uint mid;
-  uint str;
-  Tactic() {}
-  Tactic(uint g, uint d, uint m, uint s):goal(g), def(d), mid(m), str(s) {}
-};
-
 vector<Player> id2player;
-
-Tactic tactic;
-int maxTotalPrice;
-int maxIndivPrice;
+unordered_map<string, int> playerIndex; // id of each player by position and name ("pos;name")
 
 string removeBlanks(const string& s){
   uint i = 0;
@@ -59,112 +55,145 @@ string removeBlanks(const string& s){
   return s.substr(i,j-i+1);
 }
 
-bool playerPresent (const string& name, const string& pos) {
-  for (auto& p:id2player) {
-    if (p.name == name and p.position == pos) return true;
-  }
-  return false;
-}
-
-int price (const string& s) {
-  for (auto& p:id2player) 
-    if (p.name == s) return p.price;
-  return 0;
+// Returns the player with a name in a position, or nullptr if there is none
+const Player* findPlayer (const string& name, const string& pos) {
+  auto it = playerIndex.find(pos + ";" + name);
+  if (it == playerIndex.end()) return nullptr;
+  return &id2player[it->second];
 }
 
-int points (const string& s) {
-  for (auto& p:id2player) 
-    if (p.name == s) return p.points;
-  return 0;
-}
-
-int main(int argc, char** argv) {
-  if (argc != 4) {
-    cout << "Syntax: " << argv[0] << " data_base.txt query.txt solution.txt" << endl;
-    exit(1);
+// Reads the names of n players of a line of the solution, separated by ';'
+vector<string> readNames(istream& in, uint n) {
+  vector<string> names;
+  string nom;
+  if (n == 0) {
+    // the line must be empty, any name in it makes the number of players wrong
+    getline(in,nom);
+    if (nom.find_first_not_of(" \t\r") != string::npos) names.push_back(nom);
+    return names;
   }
-
-  // Read data base
-  ifstream in(argv[1]);
-  int nextId = 0;
-  while (not in.eof()) {
-    string name, club, position;
-    int p;
-    getline(in,name,';');    if (name == "") break;
-    getline(in,position,';');
-    int price; in >> price;
-    char aux; in >> aux;
-    getline(in,club,';');
-    in >> p;
-    string aux2;
-    getline(in,aux2);
-    id2player.push_back(Player(nextId++,name,position,price,club,p));
+  for (uint i = 0; i < n - 1; ++i) {
+    getline(in,nom,';'); nom = removeBlanks(nom); names.push_back(nom);
   }
-  in.close();
+  getline(in,nom); nom = removeBlanks(nom); names.push_back(nom);
+  return names;
+}
 
+// Checks the solution of a query, returns the error message or an empty string if it is right
+string verify(const string& queryFile, const string& solutionFile) {
   // Read query
-  ifstream in2(argv[2]);
+  ifstream in2(queryFile);
   uint nDef, nMig, nDav;
+  int maxTotalPrice, maxIndivPrice;
   in2 >> nDef >> nMig >> nDav >> maxTotalPrice >> maxIndivPrice;
-  tactic = Tactic(1,nDef,nMig,nDav);
   in2.close();
 
   // Read solution
-  ifstream in3(argv[3]);
+  ifstream in3(solutionFile);
   double time; in3 >> time;
-  // Read one goalkeeper
-  vector<string> goa, def, mig, dav ;
-  string aux; in3 >> aux; check(aux == "POR:", "Esperava token \"POR:\" i s'ha trobat \"" + aux + "\"");
-  string nom;
-  getline(in3,nom); nom = removeBlanks(nom); goa.push_back(nom);
-
-  in3 >> aux; check(aux == "DEF:", "Esperava token \"DEF:\" i s'ha trobat \"" + aux + "\"");
-  for (uint i = 0; i < nDef - 1; ++i) {
-    getline(in3,nom,';'); nom = removeBlanks(nom); def.push_back(nom);
-  }
-  getline(in3,nom); nom = removeBlanks(nom); def.push_back(nom);
+  string aux;
+  in3 >> aux; if (aux != "POR:") return "Esperava token \"POR:\" i s'ha trobat \"" + aux + "\"";
+  vector<string> goa = readNames(in3, 1);
+  in3 >> aux; if (aux != "DEF:") return "Esperava token \"DEF:\" i s'ha trobat \"" + aux + "\"";
+  vector<string> def = readNames(in3, nDef);
+  in3 >> aux; if (aux != "MIG:") return "Esperava token \"MIG:\" i s'ha trobat \"" + aux + "\"";
+  vector<string> mig = readNames(in3, nMig);
+  in3 >> aux; if (aux != "DAV:") return "Esperava token \"DAV:\" i s'ha trobat \"" + aux + "\"";
+  vector<string> dav = readNames(in3, nDav);
+
+  in3 >> aux; if (aux != "Punts:") return "Esperava token \"Punts:\" i s'ha trobat \"" + aux + "\"";
+  int punts; in3 >> punts;
+  in3 >> aux; if (aux != "Preu:") return "Esperava token \"Preu:\" i s'ha trobat \"" + aux + "\"";
+  int preu; in3 >> preu;
+  in3.close();
 
-  in3 >> aux; check(aux == "MIG:", "Esperava token \"MIG:\" i s'ha trobat \"" + aux + "\"");
-  for (uint i = 0; i < nMig - 1; ++i) {
-    getline(in3,nom,';'); nom = removeBlanks(nom); mig.push_back(nom);
+  if (goa.size() != 1) return "L'alineació hauria de tenir 1 porter";
+  if (def.size() != nDef) return "L'alineació hauria de tenir " + to_string(nDef) + " defenses";
+  if (mig.size() != nMig) return "L'alineació hauria de tenir " + to_string(nMig) + " migcampistes";
+  if (dav.size() != nDav) return "L'alineació hauria de tenir " + to_string(nDav) + " davanters";
+
+  // each player is looked up once, and its price and points are taken from the same record
+  vector<const Player*> lineup;
+  const vector<pair<const vector<string>*, pair<string, string>>> lines = {
+    {&goa, {"por", "porter"}}, {&def, {"def", "defensa"}}, {&mig, {"mig", "migcampista"}}, {&dav, {"dav", "davanter"}}
+  };
+  for (auto& [names, pos] : lines) {
+    for (auto& s:*names) {
+      const Player* p = findPlayer(s, pos.first);
+      if (p == nullptr) return "El jugador " + s + " no es troba a la base de dades com a " + pos.second;
+      lineup.push_back(p);
+    }
   }
-  getline(in3,nom); nom = removeBlanks(nom); mig.push_back(nom);
 
-  in3 >> aux; check(aux == "DAV:", "Esperava token \"DAV:\" i s'ha trobat \"" + aux + "\"");
-  for (uint i = 0; i < nDav - 1; ++i) {
-    getline(in3,nom,';'); nom = removeBlanks(nom); dav.push_back(nom);
+  int realPoints = 0;
+  int realPrice = 0;
+  for (const Player* p:lineup) {
+    realPrice += p->price; realPoints += p->points;
+    if (p->price > maxIndivPrice) return "El jugador " + p->name + " te preu " + to_string(p->price) + " que es major que el maxim " + to_string(maxIndivPrice);
   }
-  getline(in3,nom); nom = removeBlanks(nom); dav.push_back(nom);
 
-  in3 >> aux; check(aux == "Punts:", "Esperava token \"Punts:\" i s'ha trobat \"" + aux + "\"");
-  int punts; in3 >> punts;
-  in3 >> aux; check(aux == "Preu:", "Esperava token \"Preu:\" i s'ha trobat \"" + aux + "\"");
-  int preu; in3 >> preu;
-  in3.close();
+  if (realPoints != punts) return "L'arxiu de solució reporta un total de punts de " + to_string(punts) + " pero els punts reals de l'alineació són " + to_string(realPoints);
+  if (realPrice != preu) return "L'arxiu de solució reporta un preu de " + to_string(preu) + " pero el preu real de l'alineació és de " + to_string(realPrice);
+  if (realPrice > maxTotalPrice) return "L'arxiu de solució te un equip amb un preu de " + to_string(realPrice) + " que es major que el permes " + to_string(maxTotalPrice);
 
-  check(goa.size() == 1, "L'alineació hauria de tenir 1 porter");
-  check(def.size() == nDef, "L'alineació hauria de tenir " + to_string(nDef) + " defenses");
-  check(mig.size() == nMig, "L'alineació hauria de tenir " + to_string(nMig) + " migcampistes");
-  check(dav.size() == nDav, "L'alineació hauria de tenir " + to_string(nDav) + " davanters");
+  return "";
+}
 
-  for (auto& s:goa) check(playerPresent(s,"por"),"El jugador " + s + " no es troba a la base de dades com a porter");
-  for (auto& s:def) check(playerPresent(s,"def"),"El jugador " + s + " no es troba a la base de dades com a defensa");
-  for (auto& s:mig) check(playerPresent(s,"mig"),"El jugador " + s + " no es troba a la base de dades com a migcampista");
-  for (auto& s:dav) check(playerPresent(s,"dav"),"El jugador " + s + " no es troba a la base de dades com a davanter");
+// Checks all the solutions of a list (a query file and its solution file in each line, as the batch mode of the
+// algorithms) with several threads, writes the errors and a summary, and returns the number of errors
+int verifyBulk(const string& listFile, uint numThreads) {
+  auto start = chrono::steady_clock::now();
+  vector<pair<string, string>> files = read_batch(listFile);
+
+  vector<string> errors(files.size());
+  atomic<size_t> next = 0;
+  auto work = [&]() {
+    for (size_t i = next++; i < files.size(); i = next++) errors[i] = verify(files[i].first, files[i].second);
+  };
+  vector<thread> threads;
+  for (uint t = 0; t < numThreads; ++t) threads.emplace_back(work);
+  for (auto& t:threads) t.join();
+
+  int numErrors = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (errors[i].empty()) continue;
+    cout << files[i].second << ": ERROR: " << errors[i] << endl;
+    ++numErrors;
+  }
+  double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  cout << files.size() << " solutions checked in " << ms << " ms: " << files.size() - numErrors << " OK, " << numErrors << " ERROR" << endl;
+  return numErrors;
+}
 
-  int realPoints = 0;
-  int realPrice = 0;
+/*
+ * checker data_base.txt query.txt solution.txt
+ * checker data_base.txt --bulk list [--threads N]: checks the solution of each line of the list
+ */
+int main(int argc, char** argv) {
+  bool bulk = argc > 2 and string(argv[2]).rfind("--", 0) == 0;
+  if ((not bulk and argc != 4) or argc < 3) {
+    cout << "Syntax: " << argv[0] << " data_base.txt query.txt solution.txt" << endl;
+    cout << "        " << argv[0] << " data_base.txt --bulk list.txt [--threads N]" << endl;
+    exit(1);
+  }
 
-  for (auto& s:goa) {realPrice += price(s); realPoints += points(s); check(price(s) <= maxIndivPrice, "El jugador " + string(s) + " te preu " + to_string(price(s)) + " que es major que el maxim " + to_string(maxIndivPrice));}
-  for (auto& s:def) {realPrice += price(s); realPoints += points(s);check(price(s) <= maxIndivPrice, "El jugador " + string(s) + " te preu " + to_string(price(s)) + " que es major que el maxim " + to_string(maxIndivPrice)); }
-  for (auto& s:mig) {realPrice += price(s); realPoints += points(s);check(price(s) <= maxIndivPrice, "El jugador " + string(s) + " te preu " + to_string(price(s)) + " que es major que el maxim " + to_string(maxIndivPrice));}
-  for (auto& s:dav) {realPrice += price(s); realPoints += points(s);check(price(s) <= maxIndivPrice, "El jugador " + string(s) + " te preu " + to_string(price(s)) + " que es major que el maxim " + to_string(maxIndivPrice));}
+  // Read data base, indexed by position and name
+  Database database(argv[1]);
+  int nextId = 0;
+  database.for_each([&nextId](const PlayerRecord& r) {
+    id2player.push_back(Player(nextId++,string(r.name),string(r.position),r.price,string(r.club),r.points));
+  });
+  playerIndex.reserve(id2player.size());
+  for (auto& p:id2player) playerIndex.emplace(p.position + ";" + p.name, p.id); // the first one of repeated players
+
+  if (bulk) {
+    map<string, string> options = read_options(argc, argv, 2, {"bulk", "threads"});
+    uint numThreads = options.count("threads") ? max(1, stoi(options["threads"])) : max(1u, thread::hardware_concurrency());
+    exit(verifyBulk(options["bulk"], numThreads) == 0 ? 0 : 1);
+  }
 
-  check(realPoints == punts, "L'arxiu de solució reporta un total de punts de " + to_string(punts) + " pero els punts reals de l'alineació són " + to_string(realPoints));
-  check(realPrice == preu, "L'arxiu de solució reporta un preu de " + to_string(preu) + " pero el preu real de l'alineació és de " + to_string(realPrice));
-  check(realPrice <= maxTotalPrice, "L'arxiu de solució te un equip amb un preu de " + to_string(realPrice) + " que es major que el permes " + to_string(maxTotalPrice));
+  string error = verify(argv[2], argv[3]);
+  check(error.empty(), error);
 
-  
   cout << "OK" << endl;
-  
 }
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "database.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * Compiles a database of players (a line "name;position;price;club;points" for each player) into the binary format
+ * described in database.hh, that the solvers and the checker use directly from memory without parsing it.
+ * The players are grouped by position and sorted by price, so the players over the maximum price per player
+ * of a query are never read.
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc != 3) {
+        cerr << "Syntax: " << argv[0] << " data_base.txt data_base.db" << endl;
+        exit(1);
+    }
+
+    Database database(argv[1]);
+    vector<PlayerRecord> players;
+    database.for_each([&players](const PlayerRecord& player) {
+        players.push_back(player);
+    });
+
+    // group the players by position (in the order of positions), and sort them by price
+    stable_sort(players.begin(), players.end(), [](const PlayerRecord& p1, const PlayerRecord& p2) {
+        Position pos1 = to_position(p1.position), pos2 = to_position(p2.position);
+        if (pos1 != pos2) return pos1 < pos2;
+        return p1.price < p2.price;
+    });
+
+    uint32_t n = players.size();
+    CompiledHeader header = {};
+    memcpy(header.magic, CompiledHeader::MAGIC, 8);
+    header.version = CompiledHeader::VERSION;
+    header.num_players = n;
+    for (Position pos : positions) {
+        uint8_t p = uint8_t(pos);
+        strncpy(header.position_names[p], pos_name(pos).c_str(), 3);
+        header.position_start[p + 1] = header.position_start[p] + count_if(players.begin(), players.end(), [pos](const PlayerRecord& player) {
+            return to_position(player.position) == pos;
+        });
+    }
+
+    vector<int32_t> prices, points;
+    vector<uint8_t> player_positions;
+    vector<uint32_t> name_start = {0}, club_start;
+    string strings;
+    for (const PlayerRecord& player : players) {
+        prices.push_back(player.price);
+        points.push_back(player.points);
+        player_positions.push_back(uint8_t(to_position(player.position)));
+        strings.append(player.name);
+        name_start.push_back(strings.size());
+    }
+    club_start.push_back(strings.size());
+    for (const PlayerRecord& player : players) {
+        strings.append(player.club);
+        club_start.push_back(strings.size());
+    }
+
+    // the columns are placed one after the other, aligned to 8 bytes
+    uint64_t offset = sizeof(CompiledHeader);
+    auto place = [&offset](uint64_t bytes) {
+        uint64_t start = offset;
+        offset = (offset + bytes + 7) / 8 * 8;
+        return start;
+    };
+    header.prices_offset = place(n * sizeof(int32_t));
+    header.points_offset = place(n * sizeof(int32_t));
+    header.positions_offset = place(n * sizeof(uint8_t));
+    header.name_start_offset = place((n + 1) * sizeof(uint32_t));
+    header.club_start_offset = place((n + 1) * sizeof(uint32_t));
+    header.strings_offset = place(strings.size());
+
+    ofstream output(argv[2], ios::binary);
+    auto write_at = [&output](uint64_t offset, const void* bytes, size_t size) {
+        output.seekp(offset);
+        output.write((const char*) bytes, size);
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.prices_offset, prices.data(), n * sizeof(int32_t));
+    write_at(header.points_offset, points.data(), n * sizeof(int32_t));
+    write_at(header.positions_offset, player_positions.data(), n * sizeof(uint8_t));
+    write_at(header.name_start_offset, name_start.data(), (n + 1) * sizeof(uint32_t));
+    write_at(header.club_start_offset, club_start.data(), (n + 1) * sizeof(uint32_t));
+    write_at(header.strings_offset, strings.data(), strings.size());
+    output.close();
+
+    if (not output) {
+        cerr << "Can't write the compiled database " << argv[2] << endl;
+        exit(1);
+    }
+}
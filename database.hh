@@ -0,0 +1,218 @@
+#ifndef DATABASE_HH
+#define DATABASE_HH
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+// A line of the database: name;position;price;club;points
+// The strings point into the memory-mapped file, so they are only valid while the Database exists
+struct PlayerRecord
+{
+    string_view name, position, club;
+    int price, points;
+};
+
+
+// Returns a hash of some bytes, continuing from a previous hash: FNV-1a taking 8 bytes at a time, so a database
+// of millions of players is hashed in a few milliseconds
+inline uint64_t hash_bytes(string_view bytes, uint64_t hash = 14695981039346656037ull) {
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes.data() + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < bytes.size(); i++) hash = (hash ^ uint8_t(bytes[i])) * 1099511628211ull;
+    return hash;
+}
+
+
+/*
+ * Header of a compiled database (see compile_db.cc). After the header there are the columns of the players,
+ * at the offsets given (from the start of the file): price and points (int32_t), position (uint8_t), and the
+ * start of the name and the club of each player in the string table (uint32_t, one more than the number of players,
+ * so the string i is strings[start[i], start[i+1])). The players are grouped by position and sorted by price.
+ */
+struct CompiledHeader
+{
+    static constexpr char MAGIC[8] = {'F', 'A', 'N', 'T', 'A', 'S', 'Y', 'D'};
+    static const uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t num_players;
+    char position_names[4][4]; // name of each position, ended by '\0'
+    uint32_t position_start[5]; // the players of the position p are [position_start[p], position_start[p+1])
+    uint64_t prices_offset, points_offset, positions_offset, name_start_offset, club_start_offset, strings_offset;
+};
+
+
+/*
+ * Database of players memory-mapped from a file with a line "name;position;price;club;points" for each player
+ * (a file that can't be mapped, like a pipe, is read at once instead).
+ * The lines are parsed in a single pass without copying: the strings of each record point into the mapping
+ * and the numbers are read with from_chars.
+ * The file can also be a database compiled with compile_db, which is used directly from the mapping.
+ */
+class Database
+{
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    const CompiledHeader* header = nullptr; // only for compiled databases
+    bool mapped = false;
+    string contents; // the file, if it isn't a regular file that can be mapped (a pipe)
+
+public:
+
+    Database(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 or fstat(fd, &info) < 0) {
+            cerr << "Can't open the database " << path << endl;
+            exit(1);
+        }
+
+        if (not S_ISREG(info.st_mode)) {
+            char buffer[1 << 16];
+            ssize_t n;
+            while ((n = read(fd, buffer, sizeof(buffer))) > 0 or (n < 0 and errno == EINTR)) {
+                if (n > 0) contents.append(buffer, n);
+            }
+            if (n < 0) {
+                cerr << "Can't read the database " << path << endl;
+                exit(1);
+            }
+            data = contents.data();
+            size = contents.size();
+        }
+        else if ((size = info.st_size) > 0) {
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                cerr << "Can't map the database " << path << endl;
+                exit(1);
+            }
+            data = (const char*) mapping;
+            mapped = true;
+        }
+        close(fd);
+
+        if (size >= sizeof(CompiledHeader) and memcmp(data, CompiledHeader::MAGIC, 8) == 0) {
+            header = (const CompiledHeader*) data;
+            if (header->version != CompiledHeader::VERSION) {
+                cerr << "The database " << path << " was compiled with version " << header->version
+                     << " of compile_db, but version " << CompiledHeader::VERSION << " is needed" << endl;
+                exit(1);
+            }
+        }
+    }
+
+    Database(const Database&) = delete;
+    Database& operator= (const Database&) = delete;
+
+    ~Database() {
+        if (mapped) munmap((void*) data, size);
+    }
+
+    // Returns true if the database was compiled with compile_db
+    bool compiled() const { return header != nullptr; }
+
+    // Returns a hash of the contents of the file, that tells if two databases are the same
+    uint64_t fingerprint() const { return hash_bytes(string_view(data, size)); }
+
+    // Calls f(record) for each player of the database with above_price < price <= max_price.
+    // The players of a text database are given in the order of the file, and the ones of a compiled database
+    // are given by position and sorted by price, so the players out of the range of prices are never read.
+    template <typename F>
+    void for_each(F f, int max_price = INT_MAX, int above_price = INT_MIN) const {
+        if (header != nullptr) {
+            for_each_compiled(f, max_price, above_price);
+            return;
+        }
+
+        string_view text(data, size);
+        while (not text.empty()) {
+            size_t end = text.find('\n');
+            string_view line = text.substr(0, end);
+            text = end == string_view::npos ? string_view() : text.substr(end + 1);
+
+            if (not line.empty() and line.back() == '\r') line.remove_suffix(1);
+            if (line.empty()) continue;
+
+            PlayerRecord record;
+            if (not parse(line, record)) {
+                cerr << "Wrong line in the database: " << line << endl;
+                exit(1);
+            }
+            if (record.price > above_price and record.price <= max_price) f(record);
+        }
+    }
+
+    // Reads an integer field (that may have spaces around it), returns false if it isn't an integer
+    static bool parse_int(string_view field, int& value) {
+        while (not field.empty() and (field.front() == ' ' or field.front() == '\t')) field.remove_prefix(1);
+        while (not field.empty() and (field.back() == ' ' or field.back() == '\t')) field.remove_suffix(1);
+        auto [end, error] = from_chars(field.data(), field.data() + field.size(), value);
+        return error == errc() and end == field.data() + field.size();
+    }
+
+private:
+
+    template <typename F>
+    void for_each_compiled(F f, int max_price, int above_price) const {
+        const int32_t* prices = (const int32_t*) (data + header->prices_offset);
+        const int32_t* points = (const int32_t*) (data + header->points_offset);
+        const uint32_t* name_start = (const uint32_t*) (data + header->name_start_offset);
+        const uint32_t* club_start = (const uint32_t*) (data + header->club_start_offset);
+        const char* strings = data + header->strings_offset;
+
+        for (uint p = 0; p < 4; p++) {
+            string_view position(header->position_names[p]);
+            const int32_t* begin = upper_bound(prices + header->position_start[p], prices + header->position_start[p + 1], above_price);
+            const int32_t* end = upper_bound(begin, prices + header->position_start[p + 1], max_price);
+            for (uint i = begin - prices; i < end - prices; i++) {
+                PlayerRecord record;
+                record.name = string_view(strings + name_start[i], name_start[i + 1] - name_start[i]);
+                record.position = position;
+                record.price = prices[i];
+                record.club = string_view(strings + club_start[i], club_start[i + 1] - club_start[i]);
+                record.points = points[i];
+                f(record);
+            }
+        }
+    }
+
+    // Returns the text before the next ';' and removes it (and the ';') from the line
+    static string_view next_field(string_view& line) {
+        size_t end = line.find(';');
+        string_view field = line.substr(0, end);
+        line = end == string_view::npos ? string_view() : line.substr(end + 1);
+        return field;
+    }
+
+    static bool parse(string_view line, PlayerRecord& record) {
+        record.name = next_field(line);
+        record.position = next_field(line);
+        if (not parse_int(next_field(line), record.price)) return false;
+        record.club = next_field(line);
+        return parse_int(next_field(line), record.points);
+    }
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef DEADLINE_HH
+#define DEADLINE_HH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+
+/*
+ * Deadline of a search. A watchdog thread sleeps until the deadline and then sets a flag, so the search only reads
+ * an atomic flag to know if it has to stop, instead of reading the clock in every node.
+ * A deadline of 0 ms means that there is no deadline.
+ */
+class Deadline
+{
+private:
+    atomic<bool> reached = false;
+
+    bool finished = false;
+    mutex finish_mutex;
+    condition_variable finish_requested;
+    thread watchdog;
+
+public:
+
+    Deadline(chrono::time_point<chrono::high_resolution_clock> start_time, chrono::milliseconds duration) {
+        if (duration.count() > 0) {
+            watchdog = thread(&Deadline::run, this, start_time + duration);
+        }
+    }
+
+    Deadline(const Deadline&) = delete;
+    Deadline& operator= (const Deadline&) = delete;
+
+    ~Deadline() {
+        {
+            lock_guard<mutex> lock(finish_mutex);
+            finished = true;
+        }
+        finish_requested.notify_one();
+        if (watchdog.joinable()) watchdog.join();
+    }
+
+    // Returns true if the deadline has been reached
+    bool expired() const { return reached.load(memory_order_relaxed); }
+
+private:
+
+    void run(chrono::time_point<chrono::high_resolution_clock> end_time) {
+        unique_lock<mutex> lock(finish_mutex);
+        if (not finish_requested.wait_until(lock, end_time, [this]() { return finished; })) {
+            reached = true;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef DOMINANCE_HH
+#define DOMINANCE_HH
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * Fenwick tree that counts how many values have been inserted with a rank lower or equal to a given one.
+ */
+class FenwickTree
+{
+private:
+    vector<uint> tree;
+
+public:
+
+    FenwickTree(size_t n) : tree(n + 1, 0) {}
+
+    // Inserts a value with the given rank (0-based)
+    void insert(size_t rank) {
+        for (size_t i = rank + 1; i < tree.size(); i += i & -i) tree[i]++;
+    }
+
+    // Returns the number of values inserted with rank <= the given rank
+    uint count_up_to(size_t rank) const {
+        uint count = 0;
+        for (size_t i = rank + 1; i > 0; i -= i & -i) count += tree[i];
+        return count;
+    }
+};
+
+
+/*
+ * Finds the players that are worse in points and price than other k players, given that at most k of them
+ * can be in a lineup: one of those k players can always replace a dominated one.
+ * prices[i] and points[i] are the price and points of the i-th player, all of them from the same position.
+ *
+ * The players are swept in increasing order of price (and decreasing order of points when prices are equal),
+ * so the players that dominate a player are the ones seen before it with at least its points, which are
+ * counted with a Fenwick tree over the ranks of the points. Equal players are ordered by their index,
+ * so only one of them is dominated by the other. O(n log n).
+ */
+inline vector<bool> find_dominated(const vector<int>& prices, const vector<int>& points, uint k)
+{
+    size_t n = prices.size();
+
+    // distinct points, in decreasing order, to get the rank of the points of each player
+    vector<int> points_desc = points;
+    sort(points_desc.begin(), points_desc.end(), greater<int>());
+    points_desc.erase(unique(points_desc.begin(), points_desc.end()), points_desc.end());
+
+    vector<uint> order(n);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&prices, &points](uint i, uint j) {
+        if (prices[i] != prices[j]) return prices[i] < prices[j];
+        if (points[i] != points[j]) return points[i] > points[j];
+        return i < j;
+    });
+
+    FenwickTree better_points(points_desc.size());
+    vector<bool> dominated(n, false);
+    for (uint i : order) {
+        size_t rank = lower_bound(points_desc.begin(), points_desc.end(), points[i], greater<int>()) - points_desc.begin();
+        dominated[i] = better_points.count_up_to(rank) >= k;
+        better_points.insert(rank);
+    }
+    return dominated;
+}
+
+
+// Removes the players of a list (all from the same position) that are dominated by k other players of the list,
+// keeping the order of the remaining players
+inline void remove_dominated(PlayerList& players, uint k)
+{
+    vector<int> prices, points;
+    for (PlayerId id : players) {
+        prices.push_back(player_table.price(id));
+        points.push_back(player_table.points(id));
+    }
+
+    vector<bool> dominated = find_dominated(prices, points, k);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < players.size(); i++) {
+        if (not dominated[i]) players[kept++] = players[i];
+    }
+    players.resize(kept);
+}
+
+#endif
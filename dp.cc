@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "candidates.hh"
+#include "database.hh"
+#include "knapsack.hh"
+#include "lineup.hh"
+#include "options.hh"
+#include "player_table.hh"
+#include "stats.hh"
+
+using namespace std;
+
+
+// Global variables
+chrono::time_point<chrono::high_resolution_clock> start_time;
+
+
+PlayerTable player_table; // Global variable to store all the players
+Query query; // global variable to store the query given
+Stats run_stats; // statistics of the queries solved, written with --stats
+
+PlayerMap players_map; // Global variable to store the ids of the players to be considered, by position
+
+
+class Solution : public Lineup
+{
+public:
+
+    Solution(const Lineup& lineup) : Lineup(lineup) {}
+
+    // Writes the solution in the output file
+    void write(const string& output_file) const {
+        ofstream output(output_file);
+
+        auto end_time = chrono::high_resolution_clock::now();
+        auto duration = chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        output << fixed;
+        output.precision(1);
+        output << duration/1000.0 << endl;
+
+        Lineup::write(output);
+        output.close();
+    }
+
+};
+
+
+/*
+ * Gets the players to be considered for the query from the pool of candidates, separated by position
+ */
+void read_players_map(CandidatePool& pool)
+{
+    players_map = pool.get_candidates(query);
+}
+
+
+// Solves the query of query_file and writes the solution in output_file
+void solve(CandidatePool& pool, const string& query_file, const string& output_file) {
+
+    start_time = chrono::high_resolution_clock::now();
+    run_stats.start_query(query_file);
+
+    ScopedTimer preprocess_timer(run_stats, "preprocess");
+    query = read_query(query_file);
+    read_players_map(pool);
+    preprocess_timer.stop();
+
+    ScopedTimer search_timer(run_stats, "search");
+    Solution best_solution(knapsack_lineup(query, players_map));
+    search_timer.stop();
+    run_stats.improvement(best_solution.get_points());
+    for (Position pos : positions) run_stats.add("candidates", players_map[pos].size());
+
+    ScopedTimer write_timer(run_stats, "write");
+    best_solution.write(output_file);
+    write_timer.stop();
+    run_stats.end_query();
+}
+
+
+/*
+ * dp <database> <query> <output>
+ * dp <database> --batch <list>: solves all the queries of the list, that has a query file and an output file
+ * in each line, reading the database only once
+ */
+int main(int argc, char *argv[]) {
+
+    const string input_database = argv[1];
+    bool batch = argc > 2 and string(argv[2]).rfind("--", 0) == 0;
+
+    // optional arguments: --stats <file>, --batch <list>
+    map<string, string> options = read_options(argc, argv, batch ? 2 : 4, {"stats", "batch"});
+
+    if (options.count("stats")) run_stats.open(options["stats"]);
+
+    ScopedTimer load_timer(run_stats, "load");
+    Database database(input_database);
+    CandidatePool pool(database);
+    load_timer.stop();
+
+    if (options.count("batch")) {
+        for (auto [query_file, output_file] : read_batch(options["batch"])) {
+            solve(pool, query_file, output_file);
+        }
+    }
+    else {
+        solve(pool, argv[2], argv[3]);
+    }
+}
@@ -1,311 +1,843 @@
 #include <algorithm>
 #include <cassert>
+#include <atomic>
 #include <chrono>
-#include <cmath>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "candidates.hh"
+#include "database.hh"
+#include "deadline.hh"
+#include "greedy.hh"
+#include "knapsack.hh"
+#include "lineup.hh"
+#include "options.hh"
+#include "player_table.hh"
+#include "stats.hh"
+#include "writer.hh"
+
 using namespace std;
 
 
 // Global variables
-const vector<string> positions = {"por", "def", "mig", "dav"}; // List of all the positions: ["por", "def", "mig", "dav"] 
-map<string, int> max_points_pos = {{"por", 0}, {"def", 0}, {"mig", 0}, {"dav", 0}}; // max points of all players in each position
+PerPosition<int> max_points_pos = {{0, 0, 0, 0}}; // max points of all players in each position
 
-string output_file;
 chrono::time_point<chrono::high_resolution_clock> start_time;
 
 
-class Player
+PlayerTable player_table; // Global variable to store all the players
+Query query;
+Stats run_stats; // statistics of the queries solved, written with --stats
+
+PlayerMap players_map; // Global variable to store the ids of the players to be considered, by position
+
+
+class Solution : public Lineup
 {
 public:
-    static inline double alpha;
-    string name, pos;
-    int price, points;
 
-    Player(const string& name, const string& pos, int price, int points)
-        : name(name), pos(pos), price(price), points(points) {}
+    Solution() {}
+
+    Solution(const Lineup& lineup) : Lineup(lineup) {}
 
-    bool operator== (const Player& other) const {
-        return name == other.name and pos == other.pos and price == other.price and points == other.points;
+    // The only way a player can't be added is if its price exceeds the maximum cost
+    bool can_be_added(PlayerId id) const {
+        return get_cost() + player_table.price(id) <= query.max_cost;
     }
 
-    bool operator> (const Player& other) const {
-        return get_value() > other.get_value();
+    // Returns the next position to be added to the solution, using the order: por, def, mig, dav
+    Position get_pos_to_add() const {
+        for (Position pos : positions) {
+            if (size_at(pos) < query.max_num_players[pos]) return pos;
+        }
+        assert(false); // the solution is not complete before calling this function
+        return Position::dav;
     }
-    
-private:
-    double get_value() const {
-        if (price == 0) return 0;
-        return pow(points, alpha + 1) / price;
+
+    // Returns the maximum possible points of the solution, using the current points of the solution 
+    // and the maximum points of players in each position
+    int get_max_possible_points() const {
+        int max_possible_points = get_points();
+        for (Position pos : positions) {
+            max_possible_points += max_points_pos[pos] * (query.max_num_players[pos] - size_at(pos));
+        }
+        return max_possible_points;
     }
 };
 
+Solution best_solution; // global variable to store the best solution found so far
+unique_ptr<SolutionWriter> writer; // writes the best solution found in the output file
+atomic<int> best_points; // points of best_solution, read by all the threads to discard partial solutions
+mutex best_solution_mutex; // protects best_solution when the search uses several threads
+
+
+// Replaces the best solution found so far (and writes it) if the solution given is better
+void update_best_solution(const Solution& solution) {
+    lock_guard<mutex> lock(best_solution_mutex);
+    if (solution.get_points() > best_solution.get_points()) {
+        best_solution = solution;
+        best_points = solution.get_points();
+        writer->publish(best_solution);
+        run_stats.improvement(best_points);
+    }
+}
+
 
-struct Query
+/*
+ * Gets the players to be considered for the query from the pool of candidates, separated by position
+ * and sorted by price, so the search can stop trying players once one of them can't be afforded.
+ */
+void read_players_map(CandidatePool& pool)
 {
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    map<string, uint> max_num_players = {{"por", 1}, {"def", N1}, {"mig", N2}, {"dav", N3}};
+    players_map = pool.get_candidates(query);
+
+    for (Position pos : positions) {
+        max_points_pos[pos] = 0;
+        for (PlayerId id : players_map[pos]) max_points_pos[pos] = max(max_points_pos[pos], player_table.points(id));
+    }
+
+    // sort each of the lists of players by price (and by points when the prices are equal)
+    for (Position pos : positions) {
+        sort(players_map[pos].begin(), players_map[pos].end(), [](PlayerId p1, PlayerId p2) {
+            if (player_table.price(p1) != player_table.price(p2)) return player_table.price(p1) < player_table.price(p2);
+            return player_table.points(p1) > player_table.points(p2);
+        });
+    }
+
+}
+
+/*
+ * Upper bound of the points of any complete solution that extends a partial solution.
+ * The exhaustive search discards the partial solutions whose bound isn't better than the best solution found.
+ */
+class Bound
+{
+public:
+    virtual ~Bound() {}
+
+    virtual string name() const = 0;
+
+    // Returns an upper bound of the points of the complete solutions that extend a partial solution
+    virtual int upper_bound(const Solution& solution) const = 0;
 };
 
-Query query;
 
-using PlayerList = vector<Player>; // vector of players
-using PlayerMap = map<string, PlayerList>; // map of players by position
-PlayerMap players_map; // Global variable to store all the players
+// Bound that fills the remaining slots with the players with most points of each position, ignoring the budget
+class MaxPointsBound : public Bound
+{
+public:
+    string name() const override { return "max-points"; }
+
+    int upper_bound(const Solution& solution) const override {
+        return solution.get_max_possible_points();
+    }
+};
 
 
-class Solution
+/*
+ * Bound that uses the knapsack frontiers of each position (the maximum points of picking j players of the position
+ * with cost <= c, for every j and c) to fill the remaining slots within the remaining budget.
+ * The remaining slots of the current position are filled with its frontier, and the positions after it with
+ * the frontier of all of them combined, so it only ignores that the players must come after the last one added.
+ */
+class KnapsackBound : public Bound
 {
 private:
-    map<string, PlayerList> players;
-    int cost, points;
+    vector<PlayerKnapsack> knapsacks; // knapsack of each position, in the order of positions
+    PerPosition<Frontier> after; // frontier of filling all the positions after a given one
 
 public:
 
-    Solution() : cost(0), points(0) {
-        for (auto pos : positions) {
-            players[pos] = PlayerList();
+    KnapsackBound() {
+        for (Position pos : positions) {
+            knapsacks.emplace_back(players_map[pos], query.max_num_players[pos], query.max_cost);
+        }
+
+        Frontier nothing = {{0, 0, 0, 0}};
+        after[Position::dav] = nothing;
+        for (int p = 2; p >= 0; p--) {
+            Position next = positions[p + 1];
+            after[positions[p]] = combine(knapsacks[p + 1].frontier(query.max_num_players[next]), after[next], query.max_cost);
         }
     }
 
-    int get_cost() const { return cost; }
-    
-    int get_points() const { return points; }
+    string name() const override { return "knapsack"; }
+
+    int upper_bound(const Solution& solution) const override {
+        Position pos = solution.get_pos_to_add();
+        int budget = query.max_cost - solution.get_cost();
 
-    size_t size() const {
-        size_t size = 0;
-        for (auto pos : positions) {
-            size += players.at(pos).size();
+        const Frontier& current = knapsacks[uint8_t(pos)].frontier(query.max_num_players[pos] - solution.size_at(pos));
+        int best = -1;
+        for (const FrontierPoint& p : current) {
+            if (p.cost > budget) break;
+            int i = best_within(after[pos], budget - p.cost);
+            if (i >= 0) best = max(best, p.points + after[pos][i].points);
         }
-        return size;
+        if (best < 0) return -1; // the solution can't be completed within the budget
+        return solution.get_points() + best;
     }
+};
 
-    // The only way a player can't be added is if its price exceeds the maximum cost
-    bool can_be_added(const Player& player) const {
-        return cost + player.price <= query.max_cost;
-    }
 
-    // Adds a player to the solution
-    void add_player(const Player& player) {
-        players[player.pos].push_back(player);
-        
-        cost += player.price;
-        points += player.points;
-    }
+/*
+ * Bound given by the linear relaxation of the problem (the players can be picked fractionally), computed with
+ * its Lagrangian dual: for any lambda >= 0, lambda * budget plus the sum, for each position, of the best values
+ * of (points - lambda * price) of the players needed is an upper bound. The function is convex in lambda,
+ * so the best lambda is found with a ternary search.
+ */
+class LinearRelaxationBound : public Bound
+{
+private:
+    double max_lambda; // for bigger lambdas all the players have negative values, so the bound only gets worse
+    PerPosition<vector<double>> points, prices; // of the players of each position, in contiguous arrays
 
-    // Removes the last player added to the solution
-    // @param pos: the position of the player to be removed
-    void pop_last_player_at(string pos) {
-        Player last_player = players[pos].back();
-        players[pos].pop_back();
+public:
 
-        cost -= last_player.price;
-        points -= last_player.points;
+    LinearRelaxationBound() : max_lambda(0) {
+        for (Position pos : positions) {
+            for (PlayerId id : players_map[pos]) {
+                points[pos].push_back(player_table.points(id));
+                prices[pos].push_back(player_table.price(id));
+                if (player_table.price(id) > 0) max_lambda = max(max_lambda, double(player_table.points(id)) / player_table.price(id));
+            }
+        }
     }
 
-    // Returns the next position to be added to the solution, using the order: por, def, mig, dav
-    string get_pos_to_add() const {
-        for (auto pos : positions) {
-            if (players.at(pos).size() < query.max_num_players[pos]) return pos;
+    string name() const override { return "linear-relaxation"; }
+
+    int upper_bound(const Solution& solution) const override {
+        int budget = query.max_cost - solution.get_cost();
+        if (budget < 0) return -1;
+
+        double lo = 0, hi = max_lambda;
+        for (int iteration = 0; iteration < 40; iteration++) {
+            double m1 = lo + (hi - lo) / 3, m2 = hi - (hi - lo) / 3;
+            if (dual(solution, budget, m1) < dual(solution, budget, m2)) hi = m2;
+            else lo = m1;
         }
-        assert(false); // the solution is not complete before calling this function
+        return solution.get_points() + int(dual(solution, budget, lo) + 1e-6);
     }
 
-    // Returns the maximum possible points of the solution, using the current points of the solution 
-    // and the maximum points of players in each position
-    int get_max_possible_points() const {
-        int max_possible_points = points;
-        for (auto pos : positions) {
-            max_possible_points += max_points_pos.at(pos) * (query.max_num_players.at(pos) - players.at(pos).size());
+private:
+
+    // Value of the Lagrangian dual for a given lambda
+    double dual(const Solution& solution, int budget, double lambda) const {
+        // the bound is shared by the threads of the search, so each one has its own buffer, reused in every call
+        static thread_local vector<double> values;
+
+        double value = lambda * budget;
+        for (Position pos : positions) {
+            uint remaining = query.max_num_players[pos] - solution.size_at(pos);
+            if (remaining == 0) continue;
+
+            values.resize(points[pos].size());
+            for (size_t i = 0; i < values.size(); i++) values[i] = points[pos][i] - lambda * prices[pos][i];
+            nth_element(values.begin(), values.begin() + remaining - 1, values.end(), greater<double>());
+            for (uint i = 0; i < remaining; i++) value += values[i];
         }
-        return max_possible_points;
+        return value;
+    }
+};
+
+
+unique_ptr<Bound> bound; // bound used to discard partial solutions
+unique_ptr<Deadline> deadline; // the search leaves the partial solutions unexplored once it is reached
+
+
+// Counters of the exhaustive search. Each thread keeps its own ones, and they are added up at the end
+struct SearchStats
+{
+    long long nodes_visited = 0; // number of partial solutions visited
+    long long pruned_by_cost = 0; // number of partial solutions discarded because they exceed the maximum cost
+    long long pruned_by_bound = 0; // number of partial solutions discarded thanks to the bound
+    long long cut_by_deadline = 0; // number of partial solutions left unexplored because the deadline was reached
+    int max_unexplored_bound = 0; // highest bound of the partial solutions left unexplored
+
+    void add(const SearchStats& other) {
+        nodes_visited += other.nodes_visited;
+        pruned_by_cost += other.pruned_by_cost;
+        pruned_by_bound += other.pruned_by_bound;
+        cut_by_deadline += other.cut_by_deadline;
+        max_unexplored_bound = max(max_unexplored_bound, other.max_unexplored_bound);
     }
+};
+
+thread_local SearchStats stats; // counters of the current thread
+SearchStats total_stats; // counters of all the threads that have finished
+mutex total_stats_mutex;
 
-    // Writes the solution in the output file
-    void write() const { 
-        ofstream output(output_file);
 
-        auto end_time = chrono::high_resolution_clock::now();
-        auto duration = chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        output << fixed;
-        output.precision(1);
-        output << duration/1000.0 << endl;
+/*
+ * Recursive function that obtains the best solution using exhaustive search.
+ * Modifies the global variable solution, and stores the best partial solution found there
+ * @param prev_pos the position of the last player added to the solution
+ * @param last_index the index in players_map[prev_pos] of the last player added
+ */
+void exhaustive_search(Solution& solution, Position prev_pos = Position::por, uint last_index = 0) {
+    
+    COUNT(stats.nodes_visited);
 
-        const map<string, string> pos_to_UPPER = {{"por","POR"}, {"def","DEF"}, {"mig","MIG"}, {"dav","DAV"}};
-        for (auto pos : positions) {
-            output << pos_to_UPPER.at(pos) << ": ";
-            write_players(pos, output);
+    if (solution.size() == 11) {
+        
+        if (solution.get_points() > best_points.load(memory_order_relaxed)) {
+            update_best_solution(solution);
         }
+        return;
+    }
+
+    if (solution.get_cost() > query.max_cost) {
+        COUNT(stats.pruned_by_cost);
+        return;
+    }
+
+    int upper_bound = bound->upper_bound(solution);
+    if (upper_bound <= best_points.load(memory_order_relaxed)) {
+        COUNT(stats.pruned_by_bound);
+        return;
+    }
 
-        output << "Punts: " << points << endl;
-        output << "Preu: " << cost << endl;
-        output.close();
+    // once the deadline is reached, the rest of the tree is left unexplored, and its bound tells how far from optimal we are
+    if (deadline->expired()) {
+        stats.cut_by_deadline++;
+        stats.max_unexplored_bound = max(stats.max_unexplored_bound, upper_bound);
+        return;
+    }
+
+    // search for the next position needed to complete the solution
+    Position pos = solution.get_pos_to_add();
+    if (prev_pos != pos) last_index = 0;
+    
+    // iterate over all players from the last player added to the solution to avoid repeated partial solutions
+    for (uint i = last_index; i < players_map[pos].size(); i++) {
+        PlayerId player = players_map[pos][i];
+        
+        // the players are sorted by price, so if one can't be added, the next ones can't be added either
+        if (not solution.can_be_added(player)) break;
+
+        solution.add_player(player);
+        exhaustive_search(solution, pos, i+1);
+        solution.pop_last_player_at(pos);
     }
+}
+
+// Adds the counters of the current thread to the total ones
+void add_thread_stats() {
+    lock_guard<mutex> lock(total_stats_mutex);
+    total_stats.add(stats);
+    stats = SearchStats();
+}
+
 
+// Part of the search tree: the partial solutions that start with a given goalkeeper and player of the second slot
+// (the first defender, or the first midfielder or forward if the query has no defenders)
+struct Task
+{
+    uint goalkeeper, second; // indices in players_map of the players
+};
+
+
+/*
+ * Deque of tasks of a thread. The thread takes its tasks from the back,
+ * and the threads that have run out of tasks steal them from the front.
+ */
+class TaskDeque
+{
 private:
+    deque<Task> tasks;
+    mutex tasks_mutex;
 
-    // Writes the players of a given position in the output files
-    // @param pos: the position of the players to be written
-    void write_players(string pos, ofstream& output) const {
-        bool first = true;
-        for (Player p : players.at(pos)) {
-            if (first) first = false;
-            else output << ";";
-            output << p.name;
-        }
-        output << endl;
+public:
+
+    void push(const Task& task) {
+        lock_guard<mutex> lock(tasks_mutex);
+        tasks.push_back(task);
+    }
+
+    bool pop(Task& task) {
+        lock_guard<mutex> lock(tasks_mutex);
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
     }
 
+    bool steal(Task& task) {
+        lock_guard<mutex> lock(tasks_mutex);
+        if (tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
 };
 
-Solution best_solution; // global variable to store the best solution found so far
 
+// Runs the tasks of a thread, and steals tasks from the other threads when it has no more tasks.
+// No tasks are created while searching, so the thread ends when all the deques are empty.
+void run_tasks(uint thread, vector<TaskDeque>& deques, Position second_pos) {
+    Task task;
+    while (true) {
+        bool found = deques[thread].pop(task);
+        for (uint i = 1; i < deques.size() and not found; i++) {
+            found = deques[(thread + i) % deques.size()].steal(task);
+        }
+        if (not found) break;
 
-Query read_query(const string& query_file) {
-    ifstream file(query_file);
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    file >> N1 >> N2 >> N3 >> max_cost >> max_price_per_player;
-    return {N1, N2, N3, max_cost, max_price_per_player};
+        Solution solution;
+        solution.add_player(players_map[Position::por][task.goalkeeper]);
+        solution.add_player(players_map[second_pos][task.second]);
+        exhaustive_search(solution, second_pos, task.second + 1);
+    }
+    add_thread_stats();
 }
 
 
 /*
- * Reads the players database in data_base.txt and returns a map of all the players separated by position
- * and sorted by a heuristic determining the best players to be considered first.
+ * Exhaustive search using several threads. The search tree is split in tasks at the levels of the first two slots
+ * (the goalkeeper and the first player of the next position with players), which are dealt among the deques of the
+ * threads. All the threads discard partial solutions using the points of the best solution found by any of them.
  */
-void read_players_map()
+void parallel_exhaustive_search(uint num_threads) {
+    Position second_pos = Position::def;
+    while (query.max_num_players[second_pos] == 0) second_pos = Position(uint8_t(second_pos) + 1);
+
+    vector<TaskDeque> deques(num_threads);
+    uint num_tasks = 0;
+    const PlayerList& goalkeepers = players_map[Position::por];
+    const PlayerList& seconds = players_map[second_pos];
+    for (uint i = 0; i < goalkeepers.size(); i++) {
+        for (uint j = 0; j < seconds.size(); j++) {
+            // the players are sorted by price, so the next ones can't be afforded either
+            if (player_table.price(goalkeepers[i]) + player_table.price(seconds[j]) > query.max_cost) break;
+            deques[num_tasks++ % num_threads].push({i, j});
+        }
+    }
+
+    vector<thread> threads;
+    for (uint t = 0; t < num_threads; t++) {
+        threads.emplace_back(run_tasks, t, ref(deques), second_pos);
+    }
+    for (thread& t : threads) t.join();
+}
+
+
+// Changes of the price and points of a player, read from a delta file
+struct Change
 {
+    const PlayerRecord* player; // with the new price and points
+    int old_price, old_points;
+};
 
-    string databaseFile = "data_base.txt";
-    ifstream in(databaseFile);
+vector<Change> changes; // changes applied to the database, in incremental mode
+bool incremental = false; // if the output files may have the optimal solutions before the changes
+uint64_t database_fingerprint; // of the database without the changes
 
-    while (not in.eof()) {
-        string name, position, club;
-        int points, price;
-        getline(in, name, ';');
-        if (name == "") break;
-        
-        getline(in, position, ';');
-        in >> price;
-        char aux; in >> aux;
-
-        getline(in, club, ';');
-        in >> points;
-        string aux2;
-        getline(in,aux2);
-        
-        if (price > query.max_price_per_player) continue; // filter out the players with higher price than the maximum
-        if (points == 0) continue;
-        
-        Player player = {name, position, price, points};    
-        players_map[player.pos].push_back(player);
 
-        max_points_pos[position] = max(max_points_pos[position], points);
+/*
+ * Reads a line "name;position;price;points" with the price and points of a player of the database, returns an error
+ * message if the line is wrong (or an empty string if it's right)
+ */
+string read_change(CandidatePool& pool, const string& line, const PlayerRecord*& player, int& price, int& points) {
+    vector<string> fields;
+    stringstream fields_input(line);
+    string field;
+    while (getline(fields_input, field, ';')) fields.push_back(field);
+    bool known_position = false;
+    for (const string& name : pos_names) known_position = known_position or (fields.size() == 4 and fields[1] == name);
+    if (not known_position or not Database::parse_int(fields[2], price) or not Database::parse_int(fields[3], points)) {
+        return "wrong line (it must be name;position;price;points, with integer price and points): " + line;
     }
 
-    in.close();
+    const string& name = fields[0];
+    player = pool.find(to_position(fields[1]), name);
+    if (player == nullptr) return "the player " + name + " (" + fields[1] + ") isn't in the database";
+    // the fake players complete the lineups with price and points 0, and have the names of the ones of the pool
+    if (player->name.rfind("Fake_", 0) == 0) return "the fake player " + name + " can't change";
+    return "";
+}
 
-    // remove players that are worse in points and price than other players in the same position given the maximum number of players in each position  
-    for (auto pos : positions) {
-        for (uint i = 0; i < players_map[pos].size(); i++) {
-            Player player = players_map[pos][i];
 
-            uint count = count_if(players_map[pos].begin(), players_map[pos].end(), [player](const Player& other) {
-                return other.price <= player.price and other.points >= player.points;
-            });
-            if (count > query.max_num_players[pos]) {
-                players_map[pos].erase(players_map[pos].begin() + i);
-                i--;
-            }
+/*
+ * Reads a delta file, with a line "name;position;price;points" for each player whose price and points have changed,
+ * and applies the changes to the pool of candidates.
+ */
+void apply_delta(CandidatePool& pool, const string& delta_file) {
+    ifstream input(delta_file);
+    if (not input) {
+        cerr << "Can't open the delta file " << delta_file << endl;
+        exit(1);
+    }
 
+    string line;
+    while (getline(input, line)) {
+        if (not line.empty() and line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        const PlayerRecord* player;
+        int price, points;
+        string error = read_change(pool, line, player, price, points);
+        if (not error.empty()) {
+            cerr << "Error in the delta file " << delta_file << ": " << error << endl;
+            exit(1);
         }
+
+        // a player changed several times keeps its first price and points as the old ones
+        bool changed_before = false;
+        for (const Change& change : changes) changed_before = changed_before or change.player == player;
+        if (not changed_before) changes.push_back({player, player->price, player->points});
+        pool.update(*player, price, points);
     }
-    
-    // sort each of the lists of players by a heuristic determining the best players to be considered first
-    for (auto pos : positions) {
-        sort(players_map[pos].begin(), players_map[pos].end(), greater<Player>());
-    }
+}
 
-    // add fake players to each position given the maximum number of players in each position
-    for (auto pos : positions) {
-        for (uint i = 1; i <= query.max_num_players[pos]; i++) {
-            Player fake_player = {"Fake_" + pos + to_string(i), pos, 0, 0};
-            players_map[pos].push_back(fake_player);
+
+// Reads the solution of an output file, returns false if there is none or one of its players isn't in the database
+bool read_solution(CandidatePool& pool, const string& output_file, Solution& solution) {
+    ifstream input(output_file);
+    string line;
+    if (not getline(input, line)) return false; // time
+
+    for (Position pos : positions) {
+        if (not getline(input, line)) return false;
+        size_t start = line.find(": ");
+        if (start == string::npos) return false;
+        start += 2;
+        while (start <= line.size()) {
+            size_t end = min(line.find(';', start), line.size());
+            const PlayerRecord* player = pool.find(pos, line.substr(start, end - start));
+            if (player == nullptr) return false;
+            if (solution.size_at(pos) == query.max_num_players[pos]) return false;
+            solution.add_player(pool.id_of(*player));
+            start = end + 1;
         }
+        if (solution.size_at(pos) != query.max_num_players[pos]) return false;
     }
+    return true;
+}
+
+
+/*
+ * The certificate of an output file (output_file.cert) tells that its solution is optimal: exh only writes it after
+ * searching the whole tree (or proving that the changes can't change the optimal solution). It has the query, the
+ * points of the solution, the fingerprint of the database without the changes and a hash of the output file, so
+ * it's not valid any more if the output file is written again by another run or another algorithm. Then it has a
+ * line "name;position;price;points" for each player changed from the database, with the price and points the
+ * solution was found for, so the changes of the next delta are the ones from these.
+ */
+string certificate_file(const string& output_file) {
+    return output_file + ".cert";
+}
+
+// Returns the hash of the contents of a file, or 0 if it can't be read
+uint64_t file_hash(const string& file) {
+    ifstream input(file, ios::binary);
+    if (not input) return 0;
+    stringstream contents;
+    contents << input.rdbuf();
+    return hash_bytes(contents.str());
+}
 
+// Returns the first lines of the certificate of the solution of the query in an output file, before the changes
+string certificate_header(const string& output_file, int points) {
+    ostringstream text;
+    text << query.N1 << " " << query.N2 << " " << query.N3 << endl;
+    text << query.max_cost << endl;
+    text << query.max_price_per_player << endl;
+    text << points << endl;
+    text << hex << database_fingerprint << endl;
+    text << hex << file_hash(output_file) << endl;
+    return text.str();
+}
+
+void write_certificate(const string& output_file, int points) {
+    ofstream output(certificate_file(output_file));
+    output << certificate_header(output_file, points);
+    for (const Change& change : changes) {
+        const PlayerRecord& player = *change.player;
+        output << player.name << ";" << player.position << ";" << player.price << ";" << player.points << endl;
+    }
 }
 
 /*
- * Recursive function that obtains the best solution using exhaustive search.
- * Modifies the global variable solution, and stores the best partial solution found there
- * @param prev_pos the position of the last player added to the solution
- * @param last_index the index in players_map[prev_pos] of the last player added
+ * Reads the certificate of the solution of the query in an output file for the database, returns false if there
+ * is none. Otherwise, points are the points of the solution when it was found, and certified has the changes since
+ * then: the players that changed from the certified prices and points, with these as the old ones.
  */
-void exhaustive_search(Solution& solution, string prev_pos = "", uint last_index = 0) {
-    
-    if (solution.size() == 11) {
-        
-        if (solution.get_points() > best_solution.get_points()) {
-            best_solution = solution;
-            best_solution.write();
+bool read_certificate(CandidatePool& pool, const string& output_file, int& points, vector<Change>& certified) {
+    ifstream input(certificate_file(output_file));
+    vector<string> lines;
+    string line;
+    while (getline(input, line)) lines.push_back(line);
+    if (lines.size() < 6 or not Database::parse_int(lines[3], points)) return false;
+
+    string header;
+    for (uint i = 0; i < 6; i++) header += lines[i] + "\n";
+    if (header != certificate_header(output_file, points)) return false;
+
+    // the players of the certificate had the prices and points given, and the others the ones of the database
+    certified.clear();
+    for (uint i = 6; i < lines.size(); i++) {
+        const PlayerRecord* player;
+        int price, player_points;
+        if (not read_change(pool, lines[i], player, price, player_points).empty()) return false;
+        certified.push_back({player, price, player_points});
+    }
+    for (const Change& change : changes) {
+        bool in_certificate = false;
+        for (const Change& c : certified) in_certificate = in_certificate or c.player == change.player;
+        if (not in_certificate) certified.push_back(change);
+    }
+
+    size_t kept = 0;
+    for (const Change& change : certified) {
+        if (change.player->price != change.old_price or change.player->points != change.old_points) {
+            certified[kept++] = change;
         }
-        return;
     }
+    certified.resize(kept);
+    return true;
+}
 
-    if (solution.get_cost() > query.max_cost) return;
 
-    if (solution.get_max_possible_points() < best_solution.get_points()) return;
+// Returns the points of a solution with the old prices and points of some changes
+int points_before_changes(CandidatePool& pool, const Solution& solution, const vector<Change>& changes) {
+    int points = solution.get_points();
+    for (const Change& change : changes) {
+        PlayerId id = pool.id_of(*change.player);
+        Position pos = to_position(change.player->position);
+        for (uint i = 0; i < solution.size_at(pos); i++) {
+            if (solution.at(pos, i) == id) points += change.old_points - change.player->points;
+        }
+    }
+    return points;
+}
 
-    // search for the next position needed to complete the solution
-    string pos = solution.get_pos_to_add();
-    if (prev_pos != pos) last_index = 0;
-    
-    // iterate over all players from the last player added to the solution to avoid repeated partial solutions
-    for (uint i = last_index; i < players_map[pos].size(); i++) {
-        Player player = players_map[pos][i];
-        
-        if (solution.can_be_added(player)) {
-            solution.add_player(player);
 
-            exhaustive_search(solution, pos, i+1);
-            solution.pop_last_player_at(player.pos);
+// Returns true if a complete solution doesn't exceed the maximum cost nor the maximum price per player
+bool is_valid(const Solution& solution) {
+    if (solution.get_cost() > query.max_cost) return false;
+    for (Position pos : positions) {
+        for (uint i = 0; i < solution.size_at(pos); i++) {
+            if (player_table.price(solution.at(pos, i)) > query.max_price_per_player) return false;
         }
-        // !!! could maybe be improved by adding a break here, for example if the players are sorted by price ASC
-        // and one player isn't added, then the next players won't be added either
-        // but this could hurt performance because the first solution would be really bad
-        // Maybe we could get the greedy solution, and start comparing to it, but are we allowed???
     }
+    return true;
 }
 
+
+/*
+ * Returns true if the changes can't make the optimal solution before them (with the new prices and points) stop
+ * being optimal. Every changed player must be:
+ *  - in the solution, with the same price and at least the same points: every solution gains at most the points
+ *    that this one gains, and the solutions that can be afforded are the same.
+ *  - not in the solution, and not a candidate any more (it is dominated or too expensive), so it is never needed.
+ *  - not in the solution, and with at least its old price and at most its old points, while it could be afforded
+ *    before: the solutions with it are worse than before, when they weren't better than this one.
+ */
+bool still_optimal(CandidatePool& pool, const Solution& previous, const vector<Change>& changes) {
+    for (const Change& change : changes) {
+        const PlayerRecord& player = *change.player;
+        PlayerId id = pool.id_of(player);
+        Position pos = to_position(player.position);
+
+        bool in_previous = false;
+        for (uint i = 0; i < previous.size_at(pos); i++) in_previous = in_previous or previous.at(pos, i) == id;
+        if (in_previous) {
+            if (player.price != change.old_price or player.points < change.old_points) return false;
+            continue;
+        }
+
+        if (find(players_map[pos].begin(), players_map[pos].end(), id) == players_map[pos].end()) continue;
+        if (change.old_price > query.max_price_per_player or player.price < change.old_price or player.points > change.old_points) return false;
+    }
+    return true;
+}
+
+
 /*
  * Obtains the best solution using exhaustive search.
+ * The search starts from the solution of the greedy algorithm (or from the warm start solution given, if it is valid
+ * and better), so the bound discards partial solutions from the start.
+ * If the deadline is reached, the best solution found so far is kept, and the gap to the bound of the partial
+ * solutions left unexplored is reported.
  * Modifies the global variable solution, and stores the best partial solution found there
  */
-void exhaustive_search() {
-    Solution initial_solution;
-    exhaustive_search(initial_solution);
+void exhaustive_search(uint num_threads, const Solution* warm_start = nullptr) {
+    PlayerList candidates;
+    for (Position pos : positions) {
+        candidates.insert(candidates.end(), players_map[pos].begin(), players_map[pos].end());
+    }
+    best_solution = greedy(candidates, greedy_alpha());
+    if (warm_start != nullptr and is_valid(*warm_start) and warm_start->get_points() > best_solution.get_points()) {
+        best_solution = *warm_start;
+    }
+    best_points = best_solution.get_points();
+    writer->publish(best_solution);
+    run_stats.improvement(best_points);
+
+    if (num_threads > 1) {
+        parallel_exhaustive_search(num_threads);
+    }
+    else {
+        Solution initial_solution;
+        exhaustive_search(initial_solution);
+        add_thread_stats();
+    }
+
+    run_stats.add("nodes_visited", total_stats.nodes_visited);
+    run_stats.add("pruned_by_cost", total_stats.pruned_by_cost);
+    run_stats.add("pruned_by_bound", total_stats.pruned_by_bound);
+    run_stats.add("cut_by_deadline", total_stats.cut_by_deadline);
+
+#ifndef NO_STATS
+    cerr << "Nodes visited: " << total_stats.nodes_visited << endl;
+    cerr << "Pruned by cost: " << total_stats.pruned_by_cost << endl;
+    cerr << "Pruned by " << bound->name() << " bound: " << total_stats.pruned_by_bound << endl;
+#endif
+
+    // the optimal solution has at most the points of the best bound of the partial solutions left unexplored
+    if (total_stats.cut_by_deadline > 0) {
+        int upper_bound = max(best_points.load(), total_stats.max_unexplored_bound);
+        cerr << "Deadline reached, unexplored: " << total_stats.cut_by_deadline << endl;
+        cerr << "Upper bound: " << upper_bound << " (gap " << 100.0 * (upper_bound - best_points) / max(upper_bound, 1) << "%)" << endl;
+    }
+    else {
+        cerr << "Upper bound: " << best_points << " (optimal)" << endl;
+    }
 }
 
 
-int main(int argc, char *argv[]) {
+// Returns the bound with the given name: max-points, knapsack or linear-relaxation
+unique_ptr<Bound> make_bound(const string& name) {
+    if (name == "max-points") return make_unique<MaxPointsBound>();
+    if (name == "linear-relaxation") return make_unique<LinearRelaxationBound>();
+    if (name == "knapsack") return make_unique<KnapsackBound>();
+    cerr << "Unknown bound: " << name << endl;
+    exit(1);
+}
 
-    start_time = chrono::high_resolution_clock::now();
 
-    const string input_database = argv[1];
-    const string query_file = argv[2];
-    output_file = argv[3];
+// Options of the search
+string bound_name = "knapsack";
+uint num_threads = 1;
+int write_interval = 100;
+int deadline_ms = 0; // no deadline
+bool certify = false; // if the certificates of the optimal solutions are written (see certificate_file)
 
+
+// Solves the query of query_file and writes the best solution found in output_file
+void solve(CandidatePool& pool, const string& query_file, const string& output_file) {
+
+    start_time = chrono::high_resolution_clock::now();
+    run_stats.start_query(query_file);
+
+    ScopedTimer preprocess_timer(run_stats, "preprocess");
     query = read_query(query_file);
-    Player::alpha = pow(query.max_cost / 1e7, 0.3); // sets the static variable alpha of the class Player
+    read_players_map(pool);
+    bound = make_bound(bound_name);
+
+    // in incremental mode, the output file may have a solution before the changes, that is optimal if it has a
+    // certificate with its points before the changes since it was found
+    Solution previous;
+    vector<Change> certified;
+    int certified_points;
+    bool has_previous = incremental and read_solution(pool, output_file, previous);
+    bool previous_optimal = has_previous and read_certificate(pool, output_file, certified_points, certified)
+                            and points_before_changes(pool, previous, certified) == certified_points;
+    filesystem::remove(certificate_file(output_file)); // the output file is written again
+    preprocess_timer.stop();
+
+    writer = make_unique<SolutionWriter>(output_file, start_time, chrono::milliseconds(write_interval));
+    deadline = make_unique<Deadline>(start_time, chrono::milliseconds(deadline_ms));
+
+    best_solution = Solution();
+    best_points = 0;
+    total_stats = SearchStats();
+
+    ScopedTimer search_timer(run_stats, "search");
+    bool optimal;
+    if (previous_optimal and still_optimal(pool, previous, certified)) {
+        best_solution = previous;
+        best_points = previous.get_points();
+        writer->publish(best_solution);
+        run_stats.improvement(best_points);
+        cerr << "The changes can't change the optimal solution" << endl;
+        cerr << "Upper bound: " << best_points << " (optimal)" << endl;
+        optimal = true;
+    }
+    else {
+        exhaustive_search(num_threads, has_previous ? &previous : nullptr); // stores the best solution in the global variable solution
+        optimal = total_stats.cut_by_deadline == 0;
+    }
+    search_timer.stop();
+    deadline.reset();
+
+    ScopedTimer write_timer(run_stats, "write");
+    writer->finish();
+    if (optimal and certify) write_certificate(output_file, best_points);
+    write_timer.stop();
+    run_stats.end_query();
+}
 
-    read_players_map();
-    
-    exhaustive_search(); // stores the best solution in the global variable solution
-}
\ No newline at end of file
+
+/*
+ * exh <database> <query> <output> [options]
+ * exh <database> --batch <list> [options]: solves all the queries of the list, that has a query file and an output file
+ * in each line, reading the database only once
+ * With --delta <files>, the prices and points of the players in the files (separated by commas, applied in order)
+ * are changed from the ones of the database, and the output files may have the solutions of the queries before the
+ * changes. If the solution has the certificate that exh writes after a complete search (see certificate_file) and
+ * the changes since then can't change the optimal solution, it is kept (with the new points) without searching.
+ * Otherwise the search starts from it. So the changes of each matchday can be given as a delta with all the changes
+ * since the database, or as the list of the deltas of all the matchdays.
+ * The certificates are only written with --delta or --certify (the last argument, or --certify=), which can be used
+ * to solve the queries before the first changes.
+ */
+int main(int argc, char *argv[]) {
+
+    const string input_database = argv[1];
+    bool batch = argc > 2 and string(argv[2]).rfind("--", 0) == 0;
+
+    // optional arguments: --bound <name>, --threads <N>, --write-interval-ms <ms>, --deadline-ms <ms>,
+    // --stats <file>, --delta <files>, --batch <list>, --certify
+    map<string, string> options = read_options(argc, argv, batch ? 2 : 4, {"bound", "threads", "write-interval-ms", "deadline-ms", "stats", "delta", "batch", "certify"});
+    if (options.count("bound")) bound_name = options["bound"];
+    if (options.count("threads")) num_threads = max(1, stoi(options["threads"]));
+    if (options.count("write-interval-ms")) write_interval = stoi(options["write-interval-ms"]);
+    if (options.count("deadline-ms")) deadline_ms = stoi(options["deadline-ms"]);
+    certify = options.count("certify") or options.count("delta");
+
+    if (options.count("stats")) run_stats.open(options["stats"]);
+
+    ScopedTimer load_timer(run_stats, "load");
+    Database database(input_database);
+    CandidatePool pool(database);
+    database_fingerprint = database.fingerprint();
+    load_timer.stop();
+
+    if (options.count("delta")) {
+        string list = options["delta"];
+        for (size_t start = 0; start < list.size(); ) {
+            size_t end = min(list.find(',', start), list.size());
+            apply_delta(pool, list.substr(start, end - start));
+            start = end + 1;
+        }
+        incremental = true;
+    }
+
+    if (options.count("batch")) {
+        for (auto [query_file, output_file] : read_batch(options["batch"])) {
+            solve(pool, query_file, output_file);
+        }
+    }
+    else {
+        solve(pool, argv[2], argv[3]);
+    }
+}
@@ -0,0 +1,54 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+/*
+ * Test client of fantasy_server: sends the requests read from the standard input (one per line) to the server
+ * listening on a Unix domain socket, and writes its answers in the standard output.
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc != 2) {
+        cerr << "Syntax: " << argv[0] << " socket_path < requests" << endl;
+        exit(1);
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 or connect(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+        cerr << "Can't connect to " << argv[1] << ": " << strerror(errno) << endl;
+        exit(1);
+    }
+
+    // the requests are sent while the answers are read, and the server knows there are no more when the writing is shut
+    thread sender([fd]() {
+        string line;
+        while (getline(cin, line)) {
+            line += '\n';
+            if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) < 0) break;
+        }
+        shutdown(fd, SHUT_WR);
+    });
+
+    char bytes[4096];
+    ssize_t n;
+    while ((n = read(fd, bytes, sizeof(bytes))) > 0) {
+        cout.write(bytes, n);
+        cout.flush();
+    }
+
+    sender.join();
+    close(fd);
+}
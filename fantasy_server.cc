@@ -0,0 +1,408 @@
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "candidates.hh"
+#include "database.hh"
+#include "greedy.hh"
+#include "knapsack.hh"
+#include "lineup.hh"
+#include "options.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * Server that keeps the database in memory and solves queries sent as lines of text, from the standard input or
+ * from the connections to a Unix domain socket. Each request is a line
+ *     N1 N2 N3 max_cost max_price_per_player algo deadline_ms
+ * and its answer is the solution in the format of the output files (the time in seconds in the first line, and
+ * the lines POR, DEF, MIG, DAV, Punts and Preu), or a line "ERROR <reason>" if the request is wrong (such as
+ * a negative budget) or can't be solved.
+ * The answers of a connection are given in the order of its requests, but the requests are solved at the same time
+ * by a pool of threads, and the answers of the last queries solved are kept in a cache.
+ *
+ * The algorithms are dp (the optimal solution) and greedy. A request that is still waiting when its deadline_ms
+ * milliseconds have passed is answered with the greedy solution, that takes a few milliseconds (a deadline of 0
+ * means no deadline, as in exh and mh).
+ */
+
+
+using Clock = chrono::steady_clock;
+
+PlayerTable player_table; // Global variable to store all the players
+Query query; // not used: each request is solved for its own query
+
+const uint max_players_per_position = 10; // 11 players, and one of them is the goalkeeper
+
+
+/*
+ * Pool of threads that run the tasks submitted in the order they are submitted.
+ */
+class ThreadPool
+{
+private:
+    vector<thread> threads;
+    queue<function<void()>> tasks;
+    mutex tasks_mutex;
+    condition_variable tasks_changed;
+    bool stopping = false;
+
+public:
+
+    ThreadPool(uint num_threads) {
+        for (uint i = 0; i < num_threads; i++) {
+            threads.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(tasks_mutex);
+            stopping = true;
+        }
+        tasks_changed.notify_all();
+        for (thread& t : threads) t.join();
+    }
+
+    // Submits a task, and returns the future of its result
+    future<string> submit(function<string()> f) {
+        auto task = make_shared<packaged_task<string()>>(f);
+        {
+            lock_guard<mutex> lock(tasks_mutex);
+            tasks.push([task]() { (*task)(); });
+        }
+        tasks_changed.notify_one();
+        return task->get_future();
+    }
+
+private:
+
+    void run() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(tasks_mutex);
+                tasks_changed.wait(lock, [this]() { return stopping or not tasks.empty(); });
+                if (tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+
+/*
+ * Cache of the last solutions used, by query. When it is full, the least recently used solution is removed.
+ */
+class LruCache
+{
+private:
+    size_t capacity;
+    list<pair<string, string>> entries; // (key, solution), the most recently used first
+    unordered_map<string, list<pair<string, string>>::iterator> index; // position of each key in entries
+    mutex cache_mutex;
+
+public:
+
+    LruCache(size_t capacity) : capacity(capacity) {}
+
+    // Gets the solution of a key and marks it as the most recently used, returns false if it isn't in the cache
+    bool get(const string& key, string& solution) {
+        lock_guard<mutex> lock(cache_mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+
+        entries.splice(entries.begin(), entries, it->second);
+        solution = it->second->second;
+        return true;
+    }
+
+    void put(const string& key, const string& solution) {
+        if (capacity == 0) return;
+
+        lock_guard<mutex> lock(cache_mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        }
+        entries.push_front({key, solution});
+        index[key] = entries.begin();
+
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+};
+
+
+unique_ptr<CandidatePool> pool; // candidates of the database, shared by all the requests
+shared_mutex table_mutex; // the player table is read by all the requests, and changes when new candidates are added
+unique_ptr<ThreadPool> thread_pool; // threads that solve the requests
+unique_ptr<LruCache> cache; // solutions of the last queries
+
+
+struct Request
+{
+    Query query;
+    string algo;
+    int deadline_ms;
+};
+
+
+// Reads a request from a line, returns an error message if the line is wrong (or an empty string if it's right)
+string parse_request(const string& line, Request& request) {
+    istringstream input(line);
+    int N1, N2, N3;
+    string rest;
+    if (not (input >> N1 >> N2 >> N3 >> request.query.max_cost >> request.query.max_price_per_player
+                   >> request.algo >> request.deadline_ms) or input >> rest) {
+        return "expected N1 N2 N3 max_cost max_price_per_player algo deadline_ms";
+    }
+    if (N1 < 0 or N2 < 0 or N3 < 0 or N1 + N2 + N3 != int(max_players_per_position)) {
+        return "N1 + N2 + N3 must be " + to_string(max_players_per_position);
+    }
+    if (request.query.max_cost < 0 or request.query.max_price_per_player < 0) return "the budgets can't be negative";
+    if (request.algo != "dp" and request.algo != "greedy") return "unknown algorithm " + request.algo;
+
+    request.query = {uint(N1), uint(N2), uint(N3), request.query.max_cost, request.query.max_price_per_player};
+    return "";
+}
+
+
+// Solves a query with an algorithm, and returns the solution without the time (or an empty string if there is none)
+string solve(const Query& query, const string& algo) {
+    PlayerMap players_map;
+    {
+        // the candidates that no query had before are added to the player table
+        unique_lock<shared_mutex> lock(table_mutex);
+        players_map = pool->get_candidates(query);
+    }
+    shared_lock<shared_mutex> lock(table_mutex);
+
+    Lineup solution(query);
+    if (algo == "dp") {
+        solution = knapsack_lineup(query, players_map);
+    }
+    else {
+        PlayerList candidates;
+        for (Position pos : positions) {
+            candidates.insert(candidates.end(), players_map[pos].begin(), players_map[pos].end());
+        }
+        solution = greedy(candidates, greedy_alpha(query), query);
+    }
+    if (solution.size() != max_players_per_position + 1) return "";
+
+    ostringstream output;
+    solution.write(output);
+    return output.str();
+}
+
+
+// Answers a request received at a given time
+string answer(const string& line, Clock::time_point received) {
+    Request request = {};
+    string error = parse_request(line, request);
+    if (not error.empty()) return "ERROR " + error + "\n";
+
+    const Query& query = request.query;
+    string key = to_string(query.N1) + " " + to_string(query.N2) + " " + to_string(query.N3) + " "
+               + to_string(query.max_cost) + " " + to_string(query.max_price_per_player) + " " + request.algo;
+
+    string solution;
+    if (not cache->get(key, solution)) {
+        bool late = request.deadline_ms > 0 and Clock::now() - received > chrono::milliseconds(request.deadline_ms);
+        string algo = late ? "greedy" : request.algo;
+        try {
+            solution = solve(query, algo);
+        }
+        catch (const exception& e) { // a request that can't be solved must not stop the server
+            return "ERROR " + string(e.what()) + "\n";
+        }
+        if (solution.empty()) return "ERROR no lineup fits in the budget\n";
+        if (algo == request.algo) cache->put(key, solution);
+    }
+
+    auto duration = chrono::duration_cast<chrono::milliseconds>(Clock::now() - received).count();
+    ostringstream output;
+    output << fixed;
+    output.precision(1);
+    output << duration/1000.0 << endl;
+    return output.str() + solution;
+}
+
+
+// Reads the lines of a file descriptor
+class LineReader
+{
+private:
+    int fd;
+    string buffer;
+    bool end = false;
+
+public:
+
+    LineReader(int fd) : fd(fd) {}
+
+    // Reads the next line (without the '\n'), returns false when there are no more lines
+    bool next(string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (not line.empty() and line.back() == '\r') line.pop_back();
+                return true;
+            }
+            if (end) {
+                if (buffer.empty()) return false;
+                line = move(buffer);
+                buffer.clear();
+                return true;
+            }
+
+            char bytes[4096];
+            ssize_t n = read(fd, bytes, sizeof(bytes));
+            if (n > 0) buffer.append(bytes, n);
+            else if (n == 0 or errno != EINTR) end = true;
+        }
+    }
+};
+
+
+// Writes all the text to a file descriptor, returns false if it can't
+bool write_all(int fd, const string& text) {
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = write(fd, text.data() + written, text.size() - written);
+        if (n < 0 and errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += n;
+    }
+    return true;
+}
+
+
+/*
+ * Answers the requests read from input_fd, writing the answers to output_fd in the order of the requests.
+ * The requests are read and submitted to the thread pool by another thread, so they are solved at the same time.
+ */
+void serve(int input_fd, int output_fd) {
+    queue<future<string>> answers;
+    mutex answers_mutex;
+    condition_variable answers_changed;
+    bool all_read = false;
+
+    thread reader([&]() {
+        LineReader lines(input_fd);
+        string line;
+        while (lines.next(line)) {
+            if (line.find_first_not_of(" \t") == string::npos) continue;
+
+            Clock::time_point received = Clock::now();
+            future<string> answer_of_line = thread_pool->submit([line, received]() { return answer(line, received); });
+            lock_guard<mutex> lock(answers_mutex);
+            answers.push(move(answer_of_line));
+            answers_changed.notify_one();
+        }
+        lock_guard<mutex> lock(answers_mutex);
+        all_read = true;
+        answers_changed.notify_one();
+    });
+
+    bool open = true;
+    while (true) {
+        future<string> next_answer;
+        {
+            unique_lock<mutex> lock(answers_mutex);
+            answers_changed.wait(lock, [&]() { return all_read or not answers.empty(); });
+            if (answers.empty()) break;
+            next_answer = move(answers.front());
+            answers.pop();
+        }
+        string text = next_answer.get();
+        open = open and write_all(output_fd, text); // the answers are still awaited if the client has gone
+    }
+    reader.join();
+}
+
+
+// Accepts connections to a Unix domain socket and serves each of them in its own thread
+void serve_socket(const string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "The socket path is too long: " << path << endl;
+        exit(1);
+    }
+    strcpy(address.sun_path, path.c_str());
+
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (server_fd < 0 or bind(server_fd, (sockaddr*) &address, sizeof(address)) < 0 or listen(server_fd, 64) < 0) {
+        cerr << "Can't listen on the socket " << path << ": " << strerror(errno) << endl;
+        exit(1);
+    }
+    cerr << "Listening on " << path << endl;
+
+    while (true) {
+        int fd = accept(server_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+        thread([fd]() {
+            serve(fd, fd);
+            close(fd);
+        }).detach();
+    }
+}
+
+
+/*
+ * fantasy_server <database> [--socket <path>] [--threads <N>] [--cache-size <N>]
+ * Without --socket, the requests are read from the standard input and answered in the standard output.
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        cerr << "Syntax: " << argv[0] << " data_base.txt [--socket path] [--threads N] [--cache-size N]" << endl;
+        exit(1);
+    }
+
+    map<string, string> options = read_options(argc, argv, 2, {"socket", "threads", "cache-size"});
+    uint num_threads = options.count("threads") ? max(1, stoi(options["threads"])) : max(1u, thread::hardware_concurrency());
+    size_t cache_size = options.count("cache-size") ? stoul(options["cache-size"]) : 1000;
+
+    signal(SIGPIPE, SIG_IGN); // a client that goes away must not stop the server
+
+    Database database(argv[1]);
+    pool = make_unique<CandidatePool>(database);
+    thread_pool = make_unique<ThreadPool>(num_threads);
+    cache = make_unique<LruCache>(cache_size);
+
+    if (options.count("socket")) serve_socket(options["socket"]);
+    else serve(STDIN_FILENO, STDOUT_FILENO);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "database.hh"
+#include "options.hh"
+
+using namespace std;
+
+
+/*
+ * Generator of big databases and queries to test how the algorithms scale, deterministic from a seed.
+ *
+ * The players are drawn from the ones of a real database (data_base.txt): each generated player takes the position,
+ * price, points and club of a random real player, and its price and points are multiplied by a random factor
+ * (log-normal, about +-20%). So the positions, the prices, the points, the correlation between them and the
+ * players without points keep the distributions of the real database. The players of the real database with price
+ * and points 0 (the fake ones, that complete the lineups when the budget is too tight) are copied as they are.
+ *
+ * The queries have the formations of new_benchs (3 to 5 defenders, 3 to 5 midfielders and 1 to 3 forwards) and
+ * two kinds of budgets, from the median price of the real players: tight ones (a maximum cost of 1 to 2.5 times
+ * that price, so most players can't be afforded) and loose ones (10 to 30 times that price).
+ *
+ * The random numbers are computed here from mt19937_64, that gives the same numbers everywhere, instead of with
+ * the distributions of the standard library, that are different in each implementation.
+ */
+
+
+// Random numbers that are the same for a seed with any compiler and standard library
+class Random
+{
+private:
+    mt19937_64 gen;
+
+public:
+
+    Random(uint64_t seed) : gen(seed) {}
+
+    // Returns a real number in [0, 1)
+    double uniform() { return (gen() >> 11) * 0x1.0p-53; }
+
+    // Returns a real number in [a, b)
+    double uniform(double a, double b) { return a + (b - a) * uniform(); }
+
+    // Returns an integer in [0, n)
+    uint64_t index(uint64_t n) { return uint64_t(uniform() * n); }
+
+    // Returns a number of a standard normal distribution (Box-Muller)
+    double normal() {
+        double u1 = 1 - uniform(), u2 = uniform();
+        return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    }
+};
+
+
+// A player of the real database
+struct Model
+{
+    string name, position, club;
+    int price, points;
+};
+
+
+const double price_step = 100000; // the prices are rounded to it, as in the real database
+const double sigma = 0.2; // standard deviation of the logarithm of the random factors of the prices and points
+
+
+// Rounds a price to price_step
+int round_price(double price) {
+    return int(llround(price / price_step) * price_step);
+}
+
+
+// Writes a database with the fake players and num_players players drawn from the models
+void write_database(const vector<Model>& fakes, const vector<Model>& models, uint num_players, Random& random, const string& path) {
+    ofstream output(path);
+    if (not output) {
+        cerr << "Can't write the database " << path << endl;
+        exit(1);
+    }
+
+    for (const Model& fake : fakes) output << fake.name << ";" << fake.position << ";0;" << fake.club << ";0\n";
+
+    string line;
+    for (uint i = 0; i < num_players; i++) {
+        const Model& model = models[random.index(models.size())];
+        int price = round_price(model.price * exp(sigma * random.normal()));
+        int points = int(llround(model.points * exp(sigma * random.normal())));
+
+        line.clear();
+        line += "Player_" + to_string(i + 1) + ";" + model.position + ";" + to_string(price) + ";" + model.club + ";" + to_string(points) + "\n";
+        output << line;
+    }
+}
+
+
+// Writes a query file
+void write_query(const string& path, uint N1, uint N2, uint N3, int max_cost, int max_price_per_player) {
+    ofstream output(path);
+    output << N1 << " " << N2 << " " << N3 << endl;
+    output << max_cost << endl;
+    output << max_price_per_player << endl;
+}
+
+
+// Writes num_queries queries in a directory, half of them with tight budgets (tight-i.txt) and half with loose ones
+// (loose-i.txt), and a list of them to be solved in batch (queries.list, with the output files in the same directory)
+void write_queries(const vector<Model>& models, uint num_queries, Random& random, const string& dir) {
+    vector<int> prices;
+    for (const Model& model : models) prices.push_back(model.price);
+    nth_element(prices.begin(), prices.begin() + prices.size() / 2, prices.end());
+    double median_price = prices[prices.size() / 2];
+
+    vector<array<uint, 3>> formations;
+    for (uint N1 = 3; N1 <= 5; N1++) {
+        for (uint N2 = 3; N2 <= 5; N2++) {
+            if (N1 + N2 >= 7 and N1 + N2 <= 9) formations.push_back({N1, N2, 10 - N1 - N2});
+        }
+    }
+
+    filesystem::create_directories(dir);
+    ofstream list(dir + "/queries.list");
+    for (uint q = 0; q < num_queries; q++) {
+        bool tight = q % 2 == 0;
+        auto [N1, N2, N3] = formations[random.index(formations.size())];
+        int max_cost, max_price_per_player;
+        if (tight) {
+            max_cost = round_price(median_price * random.uniform(1, 2.5));
+            max_price_per_player = round_price(max_cost * random.uniform(0.25, 0.5));
+        }
+        else {
+            max_cost = round_price(median_price * random.uniform(10, 30));
+            max_price_per_player = round_price(max_cost * random.uniform(0.2, 0.4));
+        }
+
+        string name = (tight ? "tight-" : "loose-") + to_string(q / 2 + 1);
+        write_query(dir + "/" + name + ".txt", N1, N2, N3, max_cost, max_price_per_player);
+        list << dir << "/" << name << ".txt " << dir << "/" << name << ".out" << endl;
+    }
+}
+
+
+/*
+ * gen_data <real database> --players <N> --database <output> [--queries <dir>] [--num-queries <N>] [--seed <S>]
+ * Writes a database of N players (10000 by default, plus the fake ones) and, with --queries, num-queries queries
+ * (20 by default).
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        cerr << "Syntax: " << argv[0] << " data_base.txt [--players N] [--database file] [--queries dir] [--num-queries N] [--seed S]" << endl;
+        exit(1);
+    }
+
+    map<string, string> options = read_options(argc, argv, 2, {"players", "database", "queries", "num-queries", "seed"});
+    uint num_players = options.count("players") ? stoul(options["players"]) : 10000;
+    uint num_queries = options.count("num-queries") ? stoul(options["num-queries"]) : 20;
+    uint64_t seed = options.count("seed") ? stoull(options["seed"]) : 1;
+
+    vector<Model> fakes, models;
+    Database database(argv[1]);
+    database.for_each([&](const PlayerRecord& player) {
+        Model model = {string(player.name), string(player.position), string(player.club), player.price, player.points};
+        if (player.price == 0 and player.points == 0) fakes.push_back(model);
+        else models.push_back(model);
+    });
+    if (models.empty()) {
+        cerr << "The database " << argv[1] << " has no players" << endl;
+        exit(1);
+    }
+
+    // the database and the queries have their own random numbers, so the queries don't depend on the number of players
+    if (options.count("database")) {
+        Random random(seed);
+        write_database(fakes, models, num_players, random, options["database"]);
+    }
+    if (options.count("queries")) {
+        Random random(seed + 1);
+        write_queries(models, num_queries, random, options["queries"]);
+    }
+}
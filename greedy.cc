@@ -1,110 +1,43 @@
-#include <algorithm>
 #include <chrono>
-#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "candidates.hh"
+#include "database.hh"
+#include "greedy.hh"
+#include "lineup.hh"
+#include "local_search.hh"
+#include "options.hh"
+#include "player_table.hh"
+#include "stats.hh"
+
 using namespace std;
 
 
 // Global variables
-const vector<string> positions = {"por", "def", "mig", "dav"}; // all the possible positions
-
-string output_file;
 chrono::time_point <chrono::high_resolution_clock> start_time;
 
 
-class Player
-{
-public:
-    static inline double alpha;
-    string name, pos;
-    int price, points;
-
-    Player () {}
+PlayerTable player_table; // Global variable to store all the players
+PlayerMap players_map; // Global variable to store the ids of the players that can be added, by position
+PlayerList player_list; // Global variable to store the ids of the players that can be added
 
-    Player(const string& name, const string& pos, int price, int points)
-        : name(name), pos(pos), price(price), points(points) {}
-
-    bool operator== (const Player& other) const {
-        return name == other.name and pos == other.pos and price == other.price and points == other.points;
-    }
-
-    bool operator< (const Player& other) const {
-        return get_value() < other.get_value();
-    }
-
-private:
-    double get_value() const {
-        if (price == 0) return 0;
-        return pow(points, alpha + 1) / price;
-    }
-
-};
-
-using PlayerList = vector<Player>; // vector of players
-PlayerList player_list; // Global variable to store all the players
-
-
-struct Query
-{
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    map<string, uint> max_num_players = {{"por", 1}, {"def", N1}, {"mig", N2}, {"dav", N3}};
-};
 
 Query query; // global variable to store the query given
+Stats run_stats; // statistics of the queries solved, written with --stats
 
 
-class Solution {
-
-private:
-    map<string, PlayerList> players;
-    int cost, points;
-
+class Solution : public Lineup
+{
 public:
 
-    Solution() : cost(0), points(0) {
-        for (auto pos : positions) {
-            players[pos] = PlayerList();
-        }
-    }
-
-
-    // Returns true if some player can be added to the solution
-    bool can_some_be_added() const {
-
-        // filter out the players that can't (and will never be able to) be added
-        player_list.erase(remove_if(player_list.begin(), player_list.end(), [this](Player p){
-            return not can_be_added(p);
-        }), player_list.end());
+    Solution(const Lineup& lineup) : Lineup(lineup) {}
 
-        if (player_list.empty()) return false;
-        
-        return true;
-    }
-
-    // Adds the best player to the solution, according to a heuristic
-    void add_best_player() {
-        Player best_player;
-        
-        if (size() == 10) { // last player to be added
-            best_player = *max_element(player_list.begin(), player_list.end(), [](const Player& p1, const Player& p2) {
-                return p1.points < p2.points; // get the player with most points
-            });
-        }
-        else {
-            best_player = *max_element(player_list.begin(), player_list.end()); // get the best player according to Player comparison operator
-        }
-
-        add_player(best_player);
-    }
-    
     // Writes the solution in the output file
-    void write() const { 
+    void write(const string& output_file) const { 
         ofstream output(output_file);
 
         auto end_time = chrono::high_resolution_clock::now();
@@ -113,128 +46,106 @@ public:
         output.precision(1);
         output << duration/1000.0 << endl;
 
-        const map<string, string> pos_to_UPPER = {{"por","POR"}, {"def","DEF"}, {"mig","MIG"}, {"dav","DAV"}};
-        for (auto pos : positions) {
-            output << pos_to_UPPER.at(pos) << ": ";
-            write_players(pos, output);
-        }
-
-        output << "Punts: " << points << endl;
-        output << "Preu: " << cost << endl;
+        Lineup::write(output);
         output.close();
     }
 
-private:
-    size_t size() const {
-        size_t size = 0;
-        for (auto pos : positions) {
-            size += players.at(pos).size();
-        }
-        return size;
-    }
-
-    void add_player(const Player& player) {
-        players[player.pos].push_back(player);
-        
-        cost += player.price;
-        points += player.points;
-    }
+};
 
-    bool can_be_added(const Player& player) const {
-        if (players.at(player.pos).size() + 1 > query.max_num_players[player.pos]) return false;
-        
-        if (cost + player.price > query.max_cost) return false;
 
-        for (Player p : players.at(player.pos)) {
-            if (p == player) return false;
-        }
-        return true;
+/*
+ * Gets the players that can be added for the query from the pool of candidates. The players that can never be
+ * in an optimal solution are not needed, as the greedy never picks a player when a better and cheaper one is left.
+ */
+void read_players_list(CandidatePool& pool)
+{
+    player_list.clear();
+    players_map = pool.get_candidates(query);
+    for (Position pos : positions) {
+        player_list.insert(player_list.end(), players_map[pos].begin(), players_map[pos].end());
     }
+}
 
-    // Writes the players of a given position in the output files
-    // @param pos: the position of the players to be written
-    void write_players(string pos, ofstream& output) const {
-        bool first = true;
-        for (Player p : players.at(pos)) {
-            if (first) first = false;
-            else output << ";";
-            output << p.name;
-        }
-        output << endl;
-    }
 
-};
+// Options of the greedy
+string local_search = "none"; // strategy of the local search done after the greedy: none, first or best
+uint tabu_tenure = 0;
+uint num_alphas = 1; // values of the heuristic parameter tried
+uint num_restarts = 0; // randomized runs for each value of the parameter
+uint num_threads = 1;
+uint seed = 0;
 
 
-Query read_query(const string& query_file) {
-    ifstream file(query_file);
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    file >> N1 >> N2 >> N3 >> max_cost >> max_price_per_player;
-    return {N1, N2, N3, max_cost, max_price_per_player};
-}
+// Solves the query of query_file and writes the solution in output_file
+void solve(CandidatePool& pool, const string& query_file, const string& output_file) {
 
+    start_time = chrono::high_resolution_clock::now();
+    run_stats.start_query(query_file);
 
-/*
- * Reads the players database in data_base.txt and returns a vector of all the players (name, position, price and points)
- */
-void read_players_list()
-{
-    string databaseFile = "data_base.txt";
-    ifstream in(databaseFile);
-
-    while (not in.eof()) {
-        string name, position, club;
-        int points, price;
-        getline(in, name, ';');
-        if (name == "") break;
-        
-        getline(in, position, ';');
-        in >> price;
-        char aux; in >> aux;
-
-        getline(in, club, ';');
-        in >> points;
-        string aux2;
-        getline(in,aux2);
-        
-        if (price > query.max_price_per_player) continue; // filter out the players with higher price than the maximum
-        if (points == 0 and club != "FakeTeam") continue; // we don't store players that have 0 points (neither real player nor fake ones)
-
-        Player player = {name, position, price, points};
-        player_list.push_back(player);
+    ScopedTimer preprocess_timer(run_stats, "preprocess");
+    query = read_query(query_file);
+    read_players_list(pool);
+    preprocess_timer.stop();
+
+    ScopedTimer search_timer(run_stats, "search");
+    Solution solution = greedy_sweep(player_list, num_alphas, num_restarts, num_threads, seed);
+    run_stats.improvement(solution.get_points());
+    run_stats.add("candidates", player_list.size());
+    run_stats.add("greedy_runs", num_alphas * (num_restarts + 1));
+    if (num_alphas * (num_restarts + 1) > 1) {
+        auto duration = chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - start_time);
+        cerr << "Greedy runs: " << num_alphas * (num_restarts + 1) << " in " << duration.count()/1000.0 << " ms, best "
+             << solution.get_points() << " points" << endl;
+    }
+    if (local_search != "none") {
+        int greedy_points = solution.get_points();
+        LocalSearch search(query, players_map, to_strategy(local_search), tabu_tenure);
+        search.improve(solution);
+        if (solution.get_points() > greedy_points) run_stats.improvement(solution.get_points());
     }
+    search_timer.stop();
 
-    in.close();
+    ScopedTimer write_timer(run_stats, "write");
+    solution.write(output_file);
+    write_timer.stop();
+    run_stats.end_query();
 }
 
 
 /*
- * Function that obtains a good solution using a greedy algorithm.
- * For each player to be added, it get the best player according to a heuristic.
+ * greedy <database> <query> <output> [options]
+ * greedy <database> --batch <list> [options]: solves all the queries of the list, that has a query file and an output file
+ * in each line, reading the database only once
  */
-void greedy() {
-    Solution solution;
-    while(solution.can_some_be_added()) {
-        solution.add_best_player();
-    }
-
-    solution.write();
-}
-
-
 int main(int argc, char *argv[]) {
 
-    start_time = chrono::high_resolution_clock::now();
-
     const string input_database = argv[1];
-    const string query_file = argv[2];
-    output_file = argv[3];
-
-    query = read_query(query_file);
-    Player::alpha = pow(query.max_cost / 1e7, 0.3); // heuristic parameter for the greedy algorithm
-
-    read_players_list();
-
-    greedy();
+    bool batch = argc > 2 and string(argv[2]).rfind("--", 0) == 0;
+
+    // optional arguments: --local-search <none|first|best>, --tabu <moves>, --alphas <N>, --restarts <N>,
+    // --threads <N>, --seed <S>, --stats <file>, --batch <list>
+    map<string, string> options = read_options(argc, argv, batch ? 2 : 4,
+                                               {"local-search", "tabu", "alphas", "restarts", "threads", "seed", "stats", "batch"});
+    if (options.count("local-search")) local_search = options["local-search"];
+    if (options.count("tabu")) tabu_tenure = stoi(options["tabu"]);
+    if (options.count("alphas")) num_alphas = max(1, stoi(options["alphas"]));
+    if (options.count("restarts")) num_restarts = max(0, stoi(options["restarts"]));
+    if (options.count("threads")) num_threads = max(1, stoi(options["threads"]));
+    if (options.count("seed")) seed = stoul(options["seed"]);
+
+    if (options.count("stats")) run_stats.open(options["stats"]);
+
+    ScopedTimer load_timer(run_stats, "load");
+    Database database(input_database);
+    CandidatePool pool(database);
+    load_timer.stop();
+
+    if (options.count("batch")) {
+        for (auto [query_file, output_file] : read_batch(options["batch"])) {
+            solve(pool, query_file, output_file);
+        }
+    }
+    else {
+        solve(pool, argv[2], argv[3]);
+    }
 }
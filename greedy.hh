@@ -0,0 +1,208 @@
+#ifndef GREEDY_HH
+#define GREEDY_HH
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "lineup.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+// Returns the heuristic parameter alpha used by the greedy algorithm for a query (by default, the query being solved)
+inline double greedy_alpha(const Query& query = ::query) {
+    return pow(query.max_cost / 1e7, 0.3);
+}
+
+
+/*
+ * Heuristic keys of a list of candidates, the best player to be added is the one with the highest key.
+ * The heuristic value of a player is pow(points, alpha + 1) / price, and its key is the logarithm of it,
+ * (alpha + 1) * log(points) - log(price), that orders the players in the same way. So the logarithms of the points
+ * and the prices are computed once, and the keys for an alpha are computed in a single pass over these two columns
+ * that the compiler vectorizes, instead of computing a pow for each player and alpha.
+ * The players with price 0 get the lowest key.
+ */
+class GreedyKeys
+{
+private:
+    vector<float> log_points, log_prices; // of each candidate
+
+public:
+
+    GreedyKeys(const PlayerList& candidates) {
+        for (PlayerId id : candidates) {
+            int price = player_table.price(id);
+            log_points.push_back(price == 0 ? 0 : log(float(player_table.points(id))));
+            log_prices.push_back(price == 0 ? numeric_limits<float>::infinity() : log(float(price)));
+        }
+    }
+
+    // Computes the keys of the candidates for an alpha (keys[i] is the key of candidates[i])
+    void compute(double alpha, vector<float>& keys) const {
+        keys.resize(log_points.size());
+        float exponent = alpha + 1;
+        const float* p = log_points.data();
+        const float* c = log_prices.data();
+        float* k = keys.data();
+        for (size_t i = 0; i < keys.size(); i++) k[i] = exponent * p[i] - c[i];
+    }
+};
+
+
+/*
+ * Greedy algorithm with the heuristic keys given for the candidates (see greedy).
+ * For each player to be added, it gets the best player according to a heuristic, and the last player added is the
+ * one with most points. When several players are equally good, the first one of the candidates is picked.
+ * The candidates must contain enough players with price 0 to complete the lineup.
+ *
+ * The candidates of each position are kept in a heap by key (keys[i] is the key of candidates[i]), so the best
+ * player of each position is always at the top. The players that exceed the budget left are removed from the
+ * heaps only when they reach the top (the cost only increases, so they can never be added), and each player is
+ * pushed and popped once: it takes O(n log n) time.
+ */
+inline Lineup greedy_with_keys(const PlayerList& candidates, const vector<float>& keys, const Query& query) {
+    struct Entry
+    {
+        float key;
+        uint index; // in candidates
+    };
+    auto worse = [](const Entry& e1, const Entry& e2) {
+        if (e1.key != e2.key) return e1.key < e2.key;
+        return e1.index > e2.index;
+    };
+
+    PerPosition<vector<Entry>> heaps;
+    for (uint i = 0; i < candidates.size(); i++) {
+        heaps[player_table.pos(candidates[i])].push_back({keys[i], i});
+    }
+    for (Position pos : positions) make_heap(heaps[pos].begin(), heaps[pos].end(), worse);
+
+    Lineup solution(query);
+    while (true) {
+        int budget = query.max_cost - solution.get_cost();
+        bool last_player = solution.size() == 10;
+
+        int best = -1; // index in candidates of the player to add
+        Position best_pos = Position::por;
+        for (Position pos : positions) {
+            if (solution.size_at(pos) >= query.max_num_players[pos]) continue;
+
+            vector<Entry>& heap = heaps[pos];
+            while (not heap.empty() and player_table.price(candidates[heap.front().index]) > budget) {
+                pop_heap(heap.begin(), heap.end(), worse);
+                heap.pop_back();
+            }
+
+            if (last_player) {
+                // get the player with most points
+                for (const Entry& entry : heap) {
+                    int points = player_table.points(candidates[entry.index]);
+                    if (player_table.price(candidates[entry.index]) > budget) continue;
+                    if (best == -1 or points > player_table.points(candidates[best]) or
+                        (points == player_table.points(candidates[best]) and int(entry.index) < best)) {
+                        best = entry.index;
+                        best_pos = pos;
+                    }
+                }
+            }
+            else if (not heap.empty() and (best == -1 or worse(heaps[best_pos].front(), heap.front()))) {
+                best = heap.front().index;
+                best_pos = pos;
+            }
+        }
+        if (best == -1) break;
+
+        solution.add_player(candidates[best]);
+        if (not last_player) {
+            pop_heap(heaps[best_pos].begin(), heaps[best_pos].end(), worse);
+            heaps[best_pos].pop_back();
+        }
+    }
+    return solution;
+}
+
+
+/*
+ * Function that obtains a good solution using a greedy algorithm.
+ * For each player to be added, it gets the best player according to a heuristic, and the last player added is the
+ * one with most points. When several players are equally good, the first one of the candidates is picked.
+ * The candidates must contain enough players with price 0 to complete the lineup.
+ */
+inline Lineup greedy(const PlayerList& candidates, double alpha, const Query& query = ::query) {
+    vector<float> keys;
+    GreedyKeys(candidates).compute(alpha, keys);
+    return greedy_with_keys(candidates, keys, query);
+}
+
+
+/*
+ * Runs the greedy algorithm many times and returns the best solution found (GRASP). The heuristic parameter takes
+ * num_alphas values around the one of the query (2 * (a + 1) / (num_alphas + 1) times it), and for each of them the
+ * greedy is run once as it is and num_restarts times with the heuristic values multiplied by a random factor in
+ * [1 - noise, 1 + noise] (its logarithm is added to the keys), so equal or similar players are picked in different
+ * orders.
+ * The runs are dealt among num_threads threads, and the random numbers of the thread t start from seed + t.
+ */
+inline Lineup greedy_sweep(const PlayerList& candidates, uint num_alphas, uint num_restarts, uint num_threads,
+                           unsigned seed, double noise = 0.1, const Query& query = ::query) {
+    uint runs_per_alpha = num_restarts + 1;
+    uint num_runs = num_alphas * runs_per_alpha;
+
+    // the keys of each alpha are computed only once
+    GreedyKeys greedy_keys(candidates);
+    vector<vector<float>> keys(num_alphas);
+    for (uint a = 0; a < num_alphas; a++) {
+        greedy_keys.compute(greedy_alpha(query) * 2 * (a + 1) / (num_alphas + 1), keys[a]);
+    }
+
+    // best solution of each thread, and the run where it was found (the first run wins when the points are equal)
+    vector<Lineup> best(num_threads, Lineup(query));
+    vector<uint> best_run(num_threads, num_runs);
+    auto run_thread = [&](uint t) {
+        mt19937 gen(seed + t);
+        uniform_real_distribution<float> log_factor(log(1 - noise), log(1 + noise));
+        vector<float> randomized(candidates.size());
+
+        for (uint run = t; run < num_runs; run += num_threads) {
+            const vector<float>& alpha_keys = keys[run / runs_per_alpha];
+            Lineup solution(query);
+            if (run % runs_per_alpha == 0) {
+                solution = greedy_with_keys(candidates, alpha_keys, query);
+            }
+            else {
+                for (uint i = 0; i < candidates.size(); i++) randomized[i] = alpha_keys[i] + log_factor(gen);
+                solution = greedy_with_keys(candidates, randomized, query);
+            }
+            if (best_run[t] == num_runs or solution.get_points() > best[t].get_points()) {
+                best[t] = solution;
+                best_run[t] = run;
+            }
+        }
+    };
+
+    if (num_threads == 1) {
+        run_thread(0);
+    }
+    else {
+        vector<thread> threads;
+        for (uint t = 0; t < num_threads; t++) threads.emplace_back(run_thread, t);
+        for (thread& t : threads) t.join();
+    }
+
+    uint winner = 0;
+    for (uint t = 1; t < num_threads; t++) {
+        if (best[t].get_points() > best[winner].get_points() or
+            (best[t].get_points() == best[winner].get_points() and best_run[t] < best_run[winner])) {
+            winner = t;
+        }
+    }
+    return best[winner];
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef KNAPSACK_HH
+#define KNAPSACK_HH
+
+#include <algorithm>
+#include <vector>
+
+#include "lineup.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+/*
+ * A point of a Pareto frontier of (cost, points): a way of picking players that no other way beats
+ * in both cost and points. first and second tell how it was built (see PlayerKnapsack and combine).
+ */
+struct FrontierPoint
+{
+    int cost, points;
+    uint first, second;
+};
+
+using Frontier = vector<FrontierPoint>; // sorted by increasing cost and strictly increasing points
+
+
+// Sorts a list of points by cost and removes the ones that are not better than a cheaper one
+inline void keep_pareto(Frontier& frontier) {
+    sort(frontier.begin(), frontier.end(), [](const FrontierPoint& p1, const FrontierPoint& p2) {
+        if (p1.cost != p2.cost) return p1.cost < p2.cost;
+        return p1.points > p2.points;
+    });
+
+    size_t kept = 0;
+    for (const FrontierPoint& p : frontier) {
+        if (kept == 0 or p.points > frontier[kept - 1].points) frontier[kept++] = p;
+    }
+    frontier.resize(kept);
+}
+
+
+// Returns the index of the point with most points that costs at most max_cost, or -1 if there is none
+inline int best_within(const Frontier& frontier, int max_cost) {
+    auto it = upper_bound(frontier.begin(), frontier.end(), max_cost, [](int cost, const FrontierPoint& p) {
+        return cost < p.cost;
+    });
+    return int(it - frontier.begin()) - 1;
+}
+
+
+/*
+ * Combines two frontiers: returns the frontier of picking one point of each, with cost at most max_cost.
+ * first and second of each resulting point are the indices of the points picked in f1 and f2.
+ */
+inline Frontier combine(const Frontier& f1, const Frontier& f2, int max_cost) {
+    Frontier combined;
+    for (uint i = 0; i < f1.size(); i++) {
+        for (uint j = 0; j < f2.size() and f1[i].cost + f2[j].cost <= max_cost; j++) {
+            combined.push_back({f1[i].cost + f2[j].cost, f1[i].points + f2[j].points, i, j});
+        }
+    }
+    keep_pareto(combined);
+    return combined;
+}
+
+
+/*
+ * 0/1 knapsack over the players of one position: for each j <= k, the Pareto frontier of the ways of picking
+ * exactly j different players of the list with cost at most max_cost. The frontiers are built adding the players
+ * one by one, and only the non dominated choices are kept, so the cost axis doesn't need to be discretized.
+ */
+class PlayerKnapsack
+{
+private:
+    struct Choice { PlayerId player; int parent; }; // last player picked and the choice it was added to (-1 if none)
+
+    vector<Frontier> frontiers; // first of each point is the index of its last choice, or -1 if no player is picked
+    vector<Choice> choices;
+
+public:
+
+    PlayerKnapsack(const PlayerList& players, uint k, int max_cost) : frontiers(k + 1) {
+        frontiers[0] = {{0, 0, uint(-1), 0}};
+
+        for (PlayerId id : players) {
+            int price = player_table.price(id), points = player_table.points(id);
+
+            for (uint j = k; j >= 1; j--) {
+                Frontier& frontier = frontiers[j];
+                size_t old_size = frontier.size();
+                for (const FrontierPoint& p : frontiers[j - 1]) {
+                    if (p.cost + price > max_cost) break;
+                    frontier.push_back({p.cost + price, p.points + points, uint(choices.size()), 0});
+                    choices.push_back({id, int(p.first)});
+                }
+                if (frontier.size() != old_size) keep_pareto(frontier);
+            }
+        }
+    }
+
+    // Returns the frontier of picking exactly j players
+    const Frontier& frontier(uint j) const { return frontiers[j]; }
+
+    // Returns the players picked in a point of one of the frontiers
+    PlayerList players_of(const FrontierPoint& p) const {
+        PlayerList players;
+        for (int c = p.first; c != -1; c = choices[c].parent) {
+            players.push_back(choices[c].player);
+        }
+        return players;
+    }
+};
+
+
+/*
+ * Obtains the optimal lineup of a query solving the problem as a multiple-choice knapsack.
+ * For each position, it builds the Pareto frontier of (cost, points) of picking exactly the players needed
+ * in that position. Then it combines the frontiers of por+def and mig+dav, and for each point of the first one
+ * it takes the best point of the second one that fits in the remaining budget.
+ * The players of each position must contain enough players with price 0 to complete the lineup.
+ * If no lineup fits in the budget (a negative max_cost, or no fake players), the lineup returned is empty.
+ */
+inline Lineup knapsack_lineup(const Query& query, const PlayerMap& players_map) {
+    vector<PlayerKnapsack> knapsacks; // knapsack of each position, in the order of positions
+    for (Position pos : positions) {
+        knapsacks.emplace_back(players_map[pos], query.max_num_players[pos], query.max_cost);
+    }
+    auto frontier = [&knapsacks, &query](Position pos) -> const Frontier& {
+        return knapsacks[uint8_t(pos)].frontier(query.max_num_players[pos]);
+    };
+
+    Frontier por_def = combine(frontier(Position::por), frontier(Position::def), query.max_cost);
+    Frontier mig_dav = combine(frontier(Position::mig), frontier(Position::dav), query.max_cost);
+
+    int best_points = -1;
+    uint best_first = 0, best_second = 0;
+    for (uint i = 0; i < por_def.size(); i++) {
+        int j = best_within(mig_dav, query.max_cost - por_def[i].cost);
+        if (j >= 0 and por_def[i].points + mig_dav[j].points > best_points) {
+            best_points = por_def[i].points + mig_dav[j].points;
+            best_first = i;
+            best_second = j;
+        }
+    }
+
+    // rebuild the lineup from the points of the frontiers picked
+    Lineup lineup(query);
+    if (best_points < 0) return lineup;
+    const FrontierPoint& first = por_def[best_first];
+    const FrontierPoint& second = mig_dav[best_second];
+    PerPosition<FrontierPoint> picked;
+    picked[Position::por] = frontier(Position::por)[first.first];
+    picked[Position::def] = frontier(Position::def)[first.second];
+    picked[Position::mig] = frontier(Position::mig)[second.first];
+    picked[Position::dav] = frontier(Position::dav)[second.second];
+    for (Position pos : positions) {
+        for (PlayerId id : knapsacks[uint8_t(pos)].players_of(picked[pos])) {
+            lineup.add_player(id);
+        }
+    }
+    return lineup;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef LINEUP_HH
+#define LINEUP_HH
+
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "player_table.hh"
+
+using namespace std;
+
+
+struct Query
+{
+    uint N1, N2, N3;
+    int max_cost, max_price_per_player;
+    PerPosition<uint> max_num_players = {{1, N1, N2, N3}};
+};
+
+extern Query query; // the query being solved, defined by each program
+
+
+// Reads a query file, the lineups have 11 players so N1 + N2 + N3 must be 10, and the budgets are not negative
+inline Query read_query(const string& query_file) {
+    ifstream file(query_file);
+    int N1, N2, N3;
+    int max_cost, max_price_per_player;
+    if (not (file >> N1 >> N2 >> N3 >> max_cost >> max_price_per_player)) {
+        cerr << "Can't read the query " << query_file << endl;
+        exit(1);
+    }
+    if (N1 < 0 or N2 < 0 or N3 < 0 or N1 + N2 + N3 != 10) {
+        cerr << "Wrong query " << query_file << ": N1 + N2 + N3 must be 10" << endl;
+        exit(1);
+    }
+    if (max_cost < 0 or max_price_per_player < 0) {
+        cerr << "Wrong query " << query_file << ": the budgets can't be negative" << endl;
+        exit(1);
+    }
+    return {uint(N1), uint(N2), uint(N3), max_cost, max_price_per_player};
+}
+
+
+// Reads a list of queries to be solved in batch: each line has a query file and the output file for its solution
+inline vector<pair<string, string>> read_batch(const string& batch_file) {
+    ifstream file(batch_file);
+    vector<pair<string, string>> batch;
+    string query_file, output_file;
+    while (file >> query_file >> output_file) {
+        batch.push_back({query_file, output_file});
+    }
+    return batch;
+}
+
+
+/*
+ * A lineup of 11 players, stored as a fixed array of player ids where the players of each position
+ * are kept together in the order por, def, mig, dav. The cost and points are kept up to date
+ * as the players change, and the lineup is trivially copyable.
+ */
+class Lineup
+{
+private:
+    array<PlayerId, 11> slots;
+    PerPosition<uint8_t> first_slot; // slot where the players of each position start
+    PerPosition<uint8_t> count; // number of players in each position
+    int cost, points;
+
+public:
+
+    // Empty lineup for a query (by default, the query being solved)
+    explicit Lineup(const Query& query = ::query) : slots(), first_slot(), count(), cost(0), points(0) {
+        first_slot[Position::por] = 0;
+        first_slot[Position::def] = 1;
+        first_slot[Position::mig] = 1 + query.N1;
+        first_slot[Position::dav] = 1 + query.N1 + query.N2;
+    }
+
+    int get_cost() const { return cost; }
+
+    int get_points() const { return points; }
+
+    size_t size() const {
+        return count[Position::por] + count[Position::def] + count[Position::mig] + count[Position::dav];
+    }
+
+    // Returns the number of players in a given position
+    uint size_at(Position pos) const { return count[pos]; }
+
+    // Returns the i-th player of a given position
+    PlayerId at(Position pos, uint i) const { return slots[first_slot[pos] + i]; }
+
+    // Adds a player after the other players of its position
+    void add_player(PlayerId id) {
+        Position pos = player_table.pos(id);
+        assert(first_slot[pos] + count[pos] < (pos == Position::dav ? slots.size() : first_slot[Position(uint8_t(pos) + 1)]));
+        slots[first_slot[pos] + count[pos]++] = id;
+
+        cost += player_table.price(id);
+        points += player_table.points(id);
+    }
+
+    // Removes the last player added to a given position
+    void pop_last_player_at(Position pos) {
+        PlayerId last_player = slots[first_slot[pos] + --count[pos]];
+
+        cost -= player_table.price(last_player);
+        points -= player_table.points(last_player);
+    }
+
+    // Replaces the i-th player of a given position by another player of the same position
+    void replace_player(Position pos, uint i, PlayerId id) {
+        PlayerId& slot = slots[first_slot[pos] + i];
+
+        cost += player_table.price(id) - player_table.price(slot);
+        points += player_table.points(id) - player_table.points(slot);
+        slot = id;
+    }
+
+    // Writes the players, points and price of the lineup in the format of the output files
+    void write(ostream& output) const {
+        const string pos_to_UPPER[] = {"POR", "DEF", "MIG", "DAV"};
+        for (Position pos : positions) {
+            output << pos_to_UPPER[uint8_t(pos)] << ": ";
+            write_players(pos, output);
+        }
+
+        output << "Punts: " << points << endl;
+        output << "Preu: " << cost << endl;
+    }
+
+private:
+
+    // Writes the players of a given position separated by ";"
+    void write_players(Position pos, ostream& output) const {
+        for (uint i = 0; i < count[pos]; i++) {
+            if (i > 0) output << ";";
+            output << player_table.name(at(pos, i));
+        }
+        output << endl;
+    }
+};
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef LOCAL_SEARCH_HH
+#define LOCAL_SEARCH_HH
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lineup.hh"
+#include "player_table.hh"
+
+using namespace std;
+
+
+// How the local search picks the move to do among the ones that improve the lineup
+enum class Strategy : uint8_t {first_improvement, best_improvement};
+
+// Returns the strategy with the given name: first or best
+inline Strategy to_strategy(const string& name) {
+    if (name == "first") return Strategy::first_improvement;
+    if (name == "best") return Strategy::best_improvement;
+    cerr << "Unknown local search strategy: " << name << endl;
+    exit(1);
+}
+
+
+/*
+ * Local search that improves a complete lineup by replacing its players by other players of the same position.
+ * A move replaces one player (1-swap) or two players (2-swap, of the same or different positions), and it is only
+ * considered if the lineup doesn't exceed the maximum cost after it.
+ *
+ * The candidates of each position are sorted by price, and for each prefix of them the two players with most points
+ * that can be added are kept. So the best replacement of a player within the budget left is found with a binary
+ * search, and the best pair of replacements of two players walking the candidates of one position. The points and
+ * cost of each move are computed from the ones of the players swapped, without rebuilding the lineup.
+ *
+ * With a tabu tenure, when no move improves the lineup the best move is done anyway, and the players removed can't
+ * be added back during the next tabu_tenure moves, so the search can leave the local optima. The best lineup found
+ * is kept. Without tabu tenure, the search stops at the first local optimum.
+ * All the memory is allocated when the search is created, so improving a lineup doesn't allocate memory.
+ */
+class LocalSearch
+{
+private:
+    struct Swap
+    {
+        Position pos;
+        uint slot;
+        PlayerId player; // player added
+    };
+
+    struct Move
+    {
+        int delta_points = 0, delta_cost = 0;
+        uint num_swaps = 0; // 0 if there is no move
+        Swap swaps[2];
+    };
+
+    Query query;
+    PlayerMap candidates; // players of each position, sorted by price
+    Strategy strategy;
+    uint tabu_tenure, max_moves;
+
+    vector<bool> in_lineup; // by player id
+    vector<uint> tabu_until; // number of moves until which a player can't be added, by player id
+    PerPosition<vector<int>> best1, best2; // best and second best candidates that can be added in each prefix, or -1
+    uint num_moves = 0;
+
+public:
+
+    // The candidates of each position must include enough players with price 0 to complete the lineup
+    LocalSearch(const Query& query, const PlayerMap& players_map, Strategy strategy, uint tabu_tenure = 0, uint max_moves = 100)
+        : query(query), candidates(players_map), strategy(strategy), tabu_tenure(tabu_tenure), max_moves(max_moves),
+          in_lineup(player_table.size(), false), tabu_until(player_table.size(), 0) {
+        for (Position pos : positions) {
+            sort(candidates[pos].begin(), candidates[pos].end(), [](PlayerId p1, PlayerId p2) {
+                if (player_table.price(p1) != player_table.price(p2)) return player_table.price(p1) < player_table.price(p2);
+                return p1 < p2;
+            });
+            best1[pos].resize(candidates[pos].size());
+            best2[pos].resize(candidates[pos].size());
+        }
+    }
+
+    // Improves a complete lineup (any class with the methods of Lineup), leaving in it the best lineup found
+    template <typename L>
+    void improve(L& lineup) {
+        for (Position pos : positions) {
+            for (uint i = 0; i < lineup.size_at(pos); i++) in_lineup[lineup.at(pos, i)] = true;
+        }
+
+        L best = lineup;
+        uint first_move = num_moves;
+        while (num_moves - first_move < max_moves) {
+            update_best_candidates();
+            Move move = find_move(lineup);
+            if (move.num_swaps == 0 or (move.delta_points <= 0 and tabu_tenure == 0)) break;
+
+            for (uint s = 0; s < move.num_swaps; s++) {
+                const Swap& swap = move.swaps[s];
+                PlayerId removed = lineup.at(swap.pos, swap.slot);
+                in_lineup[removed] = false;
+                in_lineup[swap.player] = true;
+                tabu_until[removed] = num_moves + tabu_tenure;
+                lineup.replace_player(swap.pos, swap.slot, swap.player);
+            }
+            num_moves++;
+
+            if (lineup.get_points() > best.get_points()) best = lineup;
+        }
+
+        for (Position pos : positions) {
+            for (uint i = 0; i < lineup.size_at(pos); i++) in_lineup[lineup.at(pos, i)] = false;
+        }
+        lineup = best;
+    }
+
+private:
+
+    bool can_be_added(PlayerId id) const {
+        return not in_lineup[id] and tabu_until[id] <= num_moves;
+    }
+
+    // Computes, for each prefix of the candidates of each position, the two best ones that can be added
+    void update_best_candidates() {
+        for (Position pos : positions) {
+            const PlayerList& players = candidates[pos];
+            int first = -1, second = -1;
+            for (uint i = 0; i < players.size(); i++) {
+                if (can_be_added(players[i])) {
+                    int points = player_table.points(players[i]);
+                    if (first == -1 or points > player_table.points(players[first])) {
+                        second = first;
+                        first = i;
+                    }
+                    else if (second == -1 or points > player_table.points(players[second])) {
+                        second = i;
+                    }
+                }
+                best1[pos][i] = first;
+                best2[pos][i] = second;
+            }
+        }
+    }
+
+    // Returns the number of candidates of a position with price <= max_price
+    uint num_affordable(Position pos, int max_price) const {
+        const PlayerList& players = candidates[pos];
+        return upper_bound(players.begin(), players.end(), max_price, [](int price, PlayerId id) {
+            return price < player_table.price(id);
+        }) - players.begin();
+    }
+
+    // Returns true if a move is better than another one (more points, and less cost if the points are the same)
+    static bool better(const Move& m1, const Move& m2) {
+        if (m2.num_swaps == 0) return m1.num_swaps != 0;
+        if (m1.delta_points != m2.delta_points) return m1.delta_points > m2.delta_points;
+        return m1.delta_cost < m2.delta_cost;
+    }
+
+    // Returns the move to do: the first or the best improving one, or the best one if none improves the lineup
+    template <typename L>
+    Move find_move(const L& lineup) const {
+        int budget = query.max_cost - lineup.get_cost();
+        Move best_move;
+
+        // 1-swaps: the best replacement of each player
+        for (Position pos : positions) {
+            for (uint i = 0; i < lineup.size_at(pos); i++) {
+                PlayerId old_player = lineup.at(pos, i);
+                uint n = num_affordable(pos, player_table.price(old_player) + budget);
+                if (n == 0 or best1[pos][n - 1] == -1) continue;
+
+                PlayerId new_player = candidates[pos][best1[pos][n - 1]];
+                Move move;
+                move.delta_points = player_table.points(new_player) - player_table.points(old_player);
+                move.delta_cost = player_table.price(new_player) - player_table.price(old_player);
+                move.num_swaps = 1;
+                move.swaps[0] = {pos, i, new_player};
+                if (better(move, best_move)) best_move = move;
+                if (strategy == Strategy::first_improvement and best_move.delta_points > 0) return best_move;
+            }
+        }
+
+        // 2-swaps: the best pair of replacements of each pair of players
+        for (Position pos1 : positions) {
+            for (uint i = 0; i < lineup.size_at(pos1); i++) {
+                for (Position pos2 : positions) {
+                    if (pos2 < pos1) continue;
+                    for (uint j = pos2 == pos1 ? i + 1 : 0; j < lineup.size_at(pos2); j++) {
+                        Move move = best_pair(lineup, pos1, i, pos2, j, budget);
+                        if (better(move, best_move)) best_move = move;
+                        if (strategy == Strategy::first_improvement and best_move.delta_points > 0) return best_move;
+                    }
+                }
+            }
+        }
+        return best_move;
+    }
+
+    // Returns the best move replacing the i-th player of pos1 and the j-th player of pos2
+    template <typename L>
+    Move best_pair(const L& lineup, Position pos1, uint i, Position pos2, uint j, int budget) const {
+        PlayerId old1 = lineup.at(pos1, i), old2 = lineup.at(pos2, j);
+        int max_cost = budget + player_table.price(old1) + player_table.price(old2);
+        int old_points = player_table.points(old1) + player_table.points(old2);
+
+        Move best_move;
+        const PlayerList& players1 = candidates[pos1];
+        const PlayerList& players2 = candidates[pos2];
+        int n2 = num_affordable(pos2, max_cost); // candidates of pos2 that fit with the current candidate of pos1
+        for (uint c1 = 0; c1 < players1.size() and n2 > 0; c1++) {
+            PlayerId new1 = players1[c1];
+            int price1 = player_table.price(new1);
+            if (price1 > max_cost) break;
+            if (not can_be_added(new1)) continue;
+
+            // the candidates of pos1 are sorted by price, so the ones of pos2 that fit only decrease
+            while (n2 > 0 and price1 + player_table.price(players2[n2 - 1]) > max_cost) n2--;
+            if (n2 == 0) break;
+
+            int c2 = best1[pos2][n2 - 1];
+            if (c2 != -1 and players2[c2] == new1) c2 = best2[pos2][n2 - 1];
+            if (c2 == -1) continue;
+
+            PlayerId new2 = players2[c2];
+            Move move;
+            move.delta_points = player_table.points(new1) + player_table.points(new2) - old_points;
+            move.delta_cost = price1 + player_table.price(new2) - player_table.price(old1) - player_table.price(old2);
+            move.num_swaps = 2;
+            move.swaps[0] = {pos1, i, new1};
+            move.swaps[1] = {pos2, j, new2};
+            if (better(move, best_move)) best_move = move;
+        }
+        return best_move;
+    }
+};
+
+#endif
@@ -1,22 +1,36 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cassert>
 #include <chrono>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "candidates.hh"
+#include "database.hh"
+#include "deadline.hh"
+#include "greedy.hh"
+#include "knapsack.hh"
+#include "lineup.hh"
+#include "local_search.hh"
+#include "options.hh"
+#include "player_table.hh"
+#include "stats.hh"
+#include "writer.hh"
+
 using namespace std;
 
 
 // Global variables
-const vector<string> positions = {"por", "def", "mig", "dav"}; // all the possible positions
-map<string, int> max_points_pos = {{"por", 0}, {"def", 0}, {"mig", 0}, {"dav", 0}}; // max points of all players in each position
-
-string output_file;
 chrono::time_point <chrono::high_resolution_clock> start_time;
 
 // Parameters of the metaheuristic algorithm
@@ -24,11 +38,30 @@ const uint population_size = 2000; // number of solutions selected in each itera
 const uint num_combined = 500; //  number of solutions combined and mutated in each iteration
 const double mutation_rate = 0.15; // probability of mutation of each player in a mutated solution
 const uint max_no_improvement = 2000; // maximum number of iterations without improvement allowed
+const uint migration_interval = 50; // number of iterations between migrations, when there are several islands
+const uint num_migrants = 4; // number of solutions sent to the next island in each migration
+
 
+#ifdef COUNT_ALLOCATIONS
+// Counts the allocations of the thread of the search, to check that the iterations of the metaheuristic
+// don't allocate memory (compile with -DCOUNT_ALLOCATIONS)
+thread_local long long num_allocations = 0;
+atomic<long long> iteration_allocations = 0; // allocations of the iterations of all the islands
+
+void* operator new(size_t size) {
+    num_allocations++;
+    void* memory = malloc(size > 0 ? size : 1);
+    if (memory == nullptr) throw bad_alloc();
+    return memory;
+}
 
-// Random number generator
-random_device rd;
-mt19937 gen(rd());
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+#endif
+
+
+// Random number generator, each island has its own one
+thread_local mt19937 gen;
 
 // Returns a random integer between 0 and n-1
 uint rand_uint(uint n) {
@@ -43,86 +76,34 @@ double rand_0to1() {
 }
 
 
-class Player
-{
-public:
-    static inline double alpha;
-    string name, pos;
-    int price, points;
-
-    Player(const string& name, const string& pos, int price, int points)
-        : name(name), pos(pos), price(price), points(points) {}
-
-    bool operator== (const Player& other) const {
-        return name == other.name and pos == other.pos and price == other.price and points == other.points;
-    }
-
-    bool operator< (const Player& other) const {
-        return get_value() < other.get_value();
-    }
-
-    bool operator> (const Player& other) const {
-        return get_value() > other.get_value();
-    }
-
-private:
-    double get_value() const {
-        if (price == 0) return 0;
-        return pow(points, alpha + 1) / price;
-    }
-
-};
-
+PlayerTable player_table; // Global variable to store all the players
+PlayerMap players_map; // Global variable to store the ids of the players to be considered, by position
 
-using PlayerList = vector<Player>; // vector of players
-using PlayerMap = map<string, PlayerList>; // map of players by position
-PlayerMap players_map; // Global variable to store all the players
-
-
-struct Query
-{
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    map<string, uint> max_num_players = {{"por", 1}, {"def", N1}, {"mig", N2}, {"dav", N3}};
-};
 
 Query query; // global variable to store the query given
+Stats run_stats; // statistics of the queries solved, written with --stats
 
+thread_local bitset<1 << 16> in_solution; // players of the solution being checked or repaired, by id
 
-class Solution {
 
+class Solution : public Lineup
+{
 private:
-    map<string, PlayerList> players;
-    int cost, points;
     bool valid, valid_needs_update;
 
 public:
 
-    Solution() : cost(0), points(0), valid_needs_update(true) {
-        for (auto pos : positions) {
-            players[pos] = PlayerList();
-        }
-    }
-
+    Solution() : valid(false), valid_needs_update(true) {}
 
-    int get_points() const { return points; }
-
-    void add_player(const Player& player) {
-        players[player.pos].push_back(player);
-        
-        cost += player.price;
-        points += player.points;
+    Solution(const Lineup& lineup) : Lineup(lineup), valid(false), valid_needs_update(true) {}
 
+    void add_player(PlayerId id) {
+        Lineup::add_player(id);
         valid_needs_update = true;
     }
 
-    void remove_player(const Player& p) {
-        cost -= p.price;
-        points -= p.points;
-
-        auto it = find(players[p.pos].begin(), players[p.pos].end(), p);
-        players[p.pos].erase(it);
-
+    void replace_player(Position pos, uint i, PlayerId id) {
+        Lineup::replace_player(pos, i, id);
         valid_needs_update = true;
     }
 
@@ -134,169 +115,217 @@ public:
         return valid;
     }
 
-    const PlayerList& at(string pos) const {
-        return players.at(pos);
+    // Returns the fitness of a solution
+    int fitness() {
+        if (not is_valid()) return 0;
+        return get_points();
     }
 
-    bool operator> (Solution& other) {
-        return fitness() > other.fitness();
-    }
-    
-    // Writes the solution in the output file
-    void write() const { 
-        ofstream output(output_file);
-
-        auto end_time = chrono::high_resolution_clock::now();
-        auto duration = chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        output << fixed;
-        output.precision(1);
-        output << duration/1000.0 << endl;
-
-        const map<string, string> pos_to_UPPER = {{"por","POR"}, {"def","DEF"}, {"mig","MIG"}, {"dav","DAV"}};
-        for (auto pos : positions) {
-            output << pos_to_UPPER.at(pos) << ": ";
-            write_players(pos, output);
+    /*
+     * Makes the solution valid: replaces the repeated players by random players not in the solution, and then,
+     * while the solution exceeds the maximum cost, replaces its most expensive player by a random player of the same
+     * position that makes the cost fit (or, if there is none, that is cheaper). The replacements are random so the
+     * repaired solutions don't all become the same ones.
+     * The players of each position must be sorted by price, and include enough players with price 0.
+     */
+    void repair() {
+        for (Position pos : positions) {
+            for (uint i = 0; i < size_at(pos); i++) {
+                if (in_solution[at(pos, i)]) replace_player(pos, i, random_player_not_in_solution(pos));
+                in_solution[at(pos, i)] = true;
+            }
+        }
+
+        while (get_cost() > query.max_cost) {
+            Position expensive_pos = Position::por;
+            uint expensive = 0;
+            for (Position pos : positions) {
+                for (uint i = 0; i < size_at(pos); i++) {
+                    if (player_table.price(at(pos, i)) > player_table.price(at(expensive_pos, expensive))) {
+                        expensive_pos = pos;
+                        expensive = i;
+                    }
+                }
+            }
+
+            PlayerId old_player = at(expensive_pos, expensive);
+            PlayerId new_player = cheaper_player(expensive_pos, player_table.price(old_player), get_cost() - query.max_cost);
+            in_solution[old_player] = false;
+            in_solution[new_player] = true;
+            replace_player(expensive_pos, expensive, new_player);
         }
 
-        output << "Punts: " << points << endl;
-        output << "Preu: " << cost << endl;
-        output.close();
+        for (Position pos : positions) {
+            for (uint i = 0; i < size_at(pos); i++) in_solution[at(pos, i)] = false;
+        }
     }
 
 private:
 
     // Updates the valid attribute of the solution
     void update_valid() {
-        if (cost > query.max_cost) {
-            valid = false;
-            return;
-        }
-        for (auto pos : positions) {
-            // check that there are no repeated players in the same position
-            for (uint i = 0; i < players.at(pos).size(); i++) {
-                if (find(players.at(pos).begin() + i + 1, players.at(pos).end(), players.at(pos)[i]) != players.at(pos).end()) {
-                    valid = false;
-                    return;
-                }
+        valid = get_cost() <= query.max_cost and not has_repeated_players();
+    }
+
+    // Returns true if some player is more than once in the solution
+    bool has_repeated_players() const {
+        bool repeated = false;
+        for (Position pos : positions) {
+            for (uint i = 0; i < size_at(pos); i++) {
+                repeated = repeated or in_solution[at(pos, i)];
+                in_solution[at(pos, i)] = true;
             }
         }
-        valid = true;
+        for (Position pos : positions) {
+            for (uint i = 0; i < size_at(pos); i++) in_solution[at(pos, i)] = false;
+        }
+        return repeated;
     }
 
-    // Returns the fitness of a solution
-    int fitness() {
-        if (not is_valid()) return 0;
-        return points;
+    // Returns a random player of a position that is not in the solution
+    static PlayerId random_player_not_in_solution(Position pos) {
+        const PlayerList& players = players_map[pos];
+        uint start = rand_uint(players.size());
+        for (uint i = 0; i < players.size(); i++) {
+            PlayerId id = players[(start + i) % players.size()];
+            if (not in_solution[id]) return id;
+        }
+        assert(false); // there are more fake players than places in the position
+        return players[0];
     }
 
-    // Writes the players of a given position in the output files
-    // @param pos: the position of the players to be written
-    void write_players(string pos, ofstream& output) const {
-        bool first = true;
-        for (Player p : players.at(pos)) {
-            if (first) {
-                first = false;
-                output << p.name;
-            } else {
-                output << ";" << p.name;
-            }
+    /*
+     * Returns a random player of a position not in the solution whose price is at most price - excess,
+     * or, if there is none, whose price is lower than price (chosen with reservoir sampling in a single pass).
+     */
+    static PlayerId cheaper_player(Position pos, int price, int excess) {
+        const PlayerList& players = players_map[pos];
+        uint num_fitting = 0, num_cheaper = 0;
+        int fitting = -1, cheaper = -1;
+        for (uint i = 0; i < players.size() and player_table.price(players[i]) < price; i++) {
+            PlayerId id = players[i];
+            if (in_solution[id]) continue;
+            if (rand_uint(++num_cheaper) == 0) cheaper = i;
+            if (player_table.price(id) <= price - excess and rand_uint(++num_fitting) == 0) fitting = i;
         }
-        output << endl;
+        assert(cheaper != -1); // the fake players have price 0
+        return players[fitting != -1 ? fitting : cheaper];
     }
 
 };
 
 Solution best_solution; // global variable to store the best solution found so far
-using Population = vector<Solution>;
+uint best_island; // island that found best_solution
+atomic<int> best_points; // points of best_solution, read by all the islands to know if they have a better one
+mutex best_solution_mutex; // protects best_solution when there are several islands
+unique_ptr<SolutionWriter> writer; // writes the best solution found in the output file
+unique_ptr<Deadline> deadline; // the search stops once it is reached
+using Population = vector<Solution>; // arena of solutions, allocated once
+
+
+// Replaces the best solution found so far (and writes it) if the solution of an island is better.
+// When two islands find solutions with the same points, the one of the first island is kept, so a run with a seed
+// always gives the same solution.
+void update_best_solution(const Solution& solution, uint island) {
+    if (solution.get_points() < best_points.load(memory_order_relaxed)) return;
+
+    lock_guard<mutex> lock(best_solution_mutex);
+    if (solution.get_points() > best_solution.get_points() or (solution.get_points() == best_solution.get_points() and island < best_island)) {
+        best_solution = solution;
+        best_island = island;
+        best_points = solution.get_points();
+        writer->publish(best_solution);
+        run_stats.improvement(best_points);
+    }
+}
 
 
-Query read_query(const string& input_query) {
-    ifstream file(input_query);
-    uint N1, N2, N3;
-    int max_cost, max_price_per_player;
-    file >> N1 >> N2 >> N3 >> max_cost >> max_price_per_player;
-    return {N1, N2, N3, max_cost, max_price_per_player};
-}
+// Best solutions sent by an island to the next one in an iteration
+struct Migration
+{
+    uint iteration;
+    array<Solution, num_migrants> migrants;
+};
 
 
 /*
- * Reads the players database in data_base.txt and returns a map of all the players separated by position
- * and sorted by a heuristic determining the best players to be considered first.
+ * Ring of the migrations from an island to the next one. Only one island pushes and only the next one pops,
+ * so each of them only writes its own index, and the ring doesn't need locks.
  */
-void read_players_map()
+class MigrationRing
 {
+private:
+    static const uint CAPACITY = 4;
 
-    string databaseFile = "data_base.txt";
-    ifstream in(databaseFile);
-
-    while (not in.eof()) {
-        string name, position, club;
-        int points, price;
-        getline(in, name, ';');
-        if (name == "") break;
-        
-        getline(in, position, ';');
-        in >> price;
-        char aux; in >> aux;
-
-        getline(in, club, ';');
-        in >> points;
-        string aux2;
-        getline(in,aux2);
-        
-        if (price > query.max_price_per_player) continue; // filter out the players with higher price than the maximum
-        if (points == 0) continue;
-        
-        Player player = {name, position, price, points};    
-        players_map[player.pos].push_back(player);
-
-        max_points_pos[position] = max(max_points_pos[position], points);
+    array<Migration, CAPACITY> migrations;
+    atomic<uint> head = 0, tail = 0; // next migration to pop, and to push
+
+public:
+
+    bool push(const Migration& migration) {
+        uint t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == CAPACITY) return false;
+        migrations[t % CAPACITY] = migration;
+        tail.store(t + 1, memory_order_release);
+        return true;
     }
 
-    in.close();
+    bool pop(Migration& migration) {
+        uint h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        migration = migrations[h % CAPACITY];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
 
-    // remove players that are worse in points and price than other players in the same position given the maximum number of players in each position  
-    for (auto pos : positions) {
-        for (uint i = 0; i < players_map[pos].size(); i++) {
-            Player player = players_map[pos][i];
 
-            uint count = count_if(players_map[pos].begin(), players_map[pos].end(), [player](const Player& other) {
-                return other.price <= player.price and other.points >= player.points;
-            });
-            if (count > query.max_num_players[pos]) {
-                players_map[pos].erase(players_map[pos].begin() + i);
-                i--;
-            }
+// State of an island shared with the other ones
+struct Island
+{
+    MigrationRing incoming; // migrations from the previous island
+    atomic<bool> finished = false;
+    uint last_iteration = 0; // iterations done by the island, valid once finished
+};
 
-        }
-    }
+vector<unique_ptr<Island>> islands;
+bool deterministic = false; // if a seed is given, the migrations are waited for, so runs can be reproduced
+string local_search = "none"; // strategy of the local search done on the best solution of each iteration: none, first or best
+uint tabu_tenure = 0;
 
-    // add fake players to each position given the maximum number of players in each position
-    for (auto pos : positions) {
-        for (uint i = 1; i <= query.max_num_players[pos]; i++) {
-            Player fake_player = {"Fake_" + pos + to_string(i), pos, 0, 0};
-            players_map[pos].push_back(fake_player);
-        }
-    }
 
+/*
+ * Gets the players to be considered for the query from the pool of candidates, separated by position
+ */
+void read_players_map(CandidatePool& pool)
+{
+    players_map = pool.get_candidates(query);
+
+    // sort each of the lists of players by price, so the repair can stop at the first player that is too expensive
+    for (Position pos : positions) {
+        sort(players_map[pos].begin(), players_map[pos].end(), [](PlayerId p1, PlayerId p2) {
+            if (player_table.price(p1) != player_table.price(p2)) return player_table.price(p1) < player_table.price(p2);
+            return p1 < p2;
+        });
+    }
 }
 
 
-// Selects two parents from the population uniformly at random
-pair<Solution, Solution> select_parents(const Population& population) {
-    vector<Solution> parents (2);
-    sample(population.begin(), population.end(), parents.begin(), 2, gen);
-    return {parents[0], parents[1]};
+// Selects two different parents among the first size solutions of the population uniformly at random
+pair<uint, uint> select_parents(uint size) {
+    uint parent1 = rand_uint(size);
+    uint parent2 = rand_uint(size - 1);
+    if (parent2 >= parent1) parent2++;
+    return {parent1, parent2};
 }
 
 
 // Mutates a solution by removing and adding players randomly
 void mutate(Solution& solution) {
-    for (auto pos : positions) {
-        for (Player p : solution.at(pos)) {
+    for (Position pos : positions) {
+        for (uint i = 0; i < solution.size_at(pos); i++) {
             if (rand_0to1() < mutation_rate) {
-                solution.remove_player(p);
-                solution.add_player(players_map[pos][rand_uint(players_map[pos].size())]);
+                solution.replace_player(pos, i, players_map[pos][rand_uint(players_map[pos].size())]);
             }
         }
     }
@@ -304,90 +333,325 @@ void mutate(Solution& solution) {
 }
 
 
-// Recombines two solutions by removing and adding players from each position, and mutates the resulting solutions
-void recombine_and_mutate(const Solution& parent1, const Solution& parent2, Population& population) {  
+thread_local long long num_offspring = 0, num_valid_offspring = 0; // offspring of the island, and valid ones before the repair
+atomic<long long> total_generations, total_offspring, total_valid_offspring; // of all the islands, for the statistics
+
+
+// Recombines two solutions by removing and adding players from each position, and mutates the resulting solutions,
+// that are stored in the num_combined solutions starting at children
+void recombine_and_mutate(const Solution& parent1, const Solution& parent2, Solution* children) {
     for (uint i = 0; i < num_combined; ++i) {
-    
-        Solution new_solution = parent1;
-        for (auto pos : positions){
-            for (unsigned int j = 0; j < new_solution.at(pos).size(); ++j) {
+
+        Solution& new_solution = children[i];
+        new_solution = parent1;
+        for (Position pos : positions){
+            for (unsigned int j = 0; j < new_solution.size_at(pos); ++j) {
                 if (rand_uint(2) == 0) {
-                    new_solution.remove_player(new_solution.at(pos)[j]);
-                    new_solution.add_player(parent2.at(pos)[j]);
+                    new_solution.replace_player(pos, j, parent2.at(pos, j));
                 }
             }
         }
 
         mutate(new_solution);
-        population.push_back(new_solution);
+        if (run_stats.enabled()) {
+            num_offspring++;
+            if (new_solution.is_valid()) num_valid_offspring++;
+        }
+        new_solution.repair();
     }
 }
 
 
-// Selects the best individuals of the population
-void select_individuals(Population& population) {
+/*
+ * Selects the best population_size solutions among the first size ones of current, and copies them to next,
+ * the best num_best ones first (and the best of all of them at the start). ranking must have room for size elements.
+ * Only the solutions selected are placed in order (with nth_element), instead of sorting all of them.
+ */
+void select_individuals(Population& current, uint size, Population& next, vector<pair<int, uint>>& ranking, uint num_best = 1) {
+    for (uint i = 0; i < size; i++) {
+        ranking[i] = {current[i].fitness(), i};
+    }
 
-    sort(population.begin(), population.end(), [](Solution& s1, Solution& s2) {
-        return s1 > s2;
-    });
+    auto better = [](const pair<int, uint>& s1, const pair<int, uint>& s2) { return s1.first > s2.first; };
+    uint selected = min(population_size, size);
+    nth_element(ranking.begin(), ranking.begin() + (selected - 1), ranking.begin() + size, better);
+    if (num_best > 1) nth_element(ranking.begin(), ranking.begin() + (num_best - 1), ranking.begin() + selected, better);
+    iter_swap(ranking.begin(), min_element(ranking.begin(), ranking.begin() + num_best, better));
 
-    population = Population(population.begin(), population.begin() + min(population_size, (uint)population.size()));
+    for (uint i = 0; i < selected; i++) {
+        next[i] = current[ranking[i].second];
+    }
 }
 
 
-// Generates an initial population of random solutions
-Population generate_initial_population() {
-
-    Population initial_population;
+// Generates an initial population of random solutions in the first population_size solutions of the population
+void generate_initial_population(Population& population) {
 
     for (uint i = 0; i < population_size; ++i) {
-        Solution new_solution;
-        for (auto pos : positions) {
+        Solution& new_solution = population[i];
+        new_solution = Solution();
+        for (Position pos : positions) {
             for (uint j = 0; j < query.max_num_players[pos]; j++) {
                 new_solution.add_player(players_map[pos][rand_uint(players_map[pos].size())]);
             }
         }
-        initial_population.push_back(new_solution);
+        new_solution.repair();
     }
-    return initial_population;
-    
+
+}
+
+
+// Returns an upper bound of the points of any solution that takes the budget into account: the points of the
+// optimal solution of the knapsack of each position (knapsack.hh), that takes a few milliseconds
+int knapsack_bound() {
+    return knapsack_lineup(query, players_map).get_points();
+}
+
+
+// Returns the fraction of different solutions among the first size ones of a population
+double diversity(const Population& population, uint size) {
+    vector<array<PlayerId, 11>> lineups;
+    for (uint i = 0; i < size; i++) {
+        array<PlayerId, 11> players;
+        uint n = 0;
+        for (Position pos : positions) {
+            uint first = n;
+            for (uint j = 0; j < population[i].size_at(pos); j++) players[n++] = population[i].at(pos, j);
+            sort(players.begin() + first, players.begin() + n);
+        }
+        lineups.push_back(players);
+    }
+    sort(lineups.begin(), lineups.end());
+    return double(unique(lineups.begin(), lineups.end()) - lineups.begin()) / max(size, 1u);
 }
 
 
-void metaheuristica(int population_size) {
+// Sends the best solutions of an island (the first num_migrants of the population) to the next island
+void send_migrants(uint island, uint iteration, const Solution* best) {
+    Migration migration;
+    migration.iteration = iteration;
+    copy(best, best + num_migrants, migration.migrants.begin());
 
-    Population population = generate_initial_population();
-    uint no_improvement_count = 0;
+    Island& next_island = *islands[(island + 1) % islands.size()];
+    while (not next_island.incoming.push(migration)) {
+        // the migration is dropped if the ring is full, unless the run must be reproducible
+        if (not deterministic or next_island.finished or deadline->expired()) return;
+        this_thread::yield();
+    }
+}
+
+
+// Receives the migrants sent to an island, stores them in migrants and returns their number
+uint receive_migrants(uint island, uint iteration, Solution* migrants) {
+    Island& this_island = *islands[island];
+    const Island& previous_island = *islands[(island + islands.size() - 1) % islands.size()];
+
+    Migration migration;
+    if (not deterministic) {
+        bool received = false;
+        while (this_island.incoming.pop(migration)) received = true; // the newest migration is kept
+        if (not received) return 0;
+    }
+    else {
+        // the migration sent in the previous migration iteration is waited for (not the one of this iteration, that
+        // the previous island may be waiting for its own migrants to send), unless the previous island finished before
+        if (iteration == migration_interval) return 0;
+        while (not this_island.incoming.pop(migration)) {
+            if (previous_island.finished.load(memory_order_acquire) and previous_island.last_iteration < iteration - migration_interval) return 0;
+            if (deadline->expired()) return 0;
+            this_thread::yield();
+        }
+    }
+    copy(migration.migrants.begin(), migration.migrants.end(), migrants);
+    return num_migrants;
+}
 
-    while (no_improvement_count++ < max_no_improvement) {
-    
-        auto [parent1, parent2] = select_parents(population);
-        recombine_and_mutate(parent1, parent2, population);
-        select_individuals(population);
 
-        Solution candidate = population[0];
-        if (candidate.get_points() > best_solution.get_points() and candidate.is_valid()) {
-            best_solution = candidate;            
-            best_solution.write();
+/*
+ * Genetic algorithm of an island: it stops after max_no_improvement iterations without improving its best solution,
+ * or when the deadline is reached. If there are several islands, every migration_interval iterations the best
+ * solutions of each island are sent to the next one, where they compete with the rest to be selected.
+ */
+void run_island(uint island, uint seed) {
+
+    gen.seed(seed);
+
+    // the current population is followed by the solutions combined from it (and the migrants received), and the best
+    // ones are copied to the next population, so the iterations don't allocate memory
+    Population current(population_size + num_combined + num_migrants), next(population_size + num_combined + num_migrants);
+    vector<pair<int, uint>> ranking(population_size + num_combined + num_migrants);
+
+    unique_ptr<LocalSearch> search;
+    if (local_search != "none") search = make_unique<LocalSearch>(query, players_map, to_strategy(local_search), tabu_tenure);
+
+    generate_initial_population(current);
+    uint no_improvement_count = 0, iteration = 0;
+    int island_best_points = 0;
+
+#ifdef COUNT_ALLOCATIONS
+    long long allocations_before = num_allocations;
+#endif
+
+    while (no_improvement_count++ < max_no_improvement and not deadline->expired()) {
+        iteration++;
+        bool migration = islands.size() > 1 and iteration % migration_interval == 0;
+
+        auto [parent1, parent2] = select_parents(population_size);
+        recombine_and_mutate(current[parent1], current[parent2], &current[population_size]);
+        uint size = population_size + num_combined;
+        if (migration) size += receive_migrants(island, iteration, &current[size]);
+        select_individuals(current, size, next, ranking, migration ? num_migrants : 1);
+        swap(current, next);
+        if (migration) send_migrants(island, iteration, &current[0]);
+
+        Solution& candidate = current[0];
+        if (search) search->improve(candidate); // the improved solution stays in the population
+        if (candidate.get_points() > island_best_points and candidate.is_valid()) {
+            island_best_points = candidate.get_points();
+            update_best_solution(candidate, island);
             no_improvement_count = 0;
         }
     }
 
+#ifdef COUNT_ALLOCATIONS
+    iteration_allocations += num_allocations - allocations_before;
+#endif
+
+    if (run_stats.enabled()) {
+        run_stats.add("generations", iteration);
+        run_stats.add("offspring", num_offspring);
+        run_stats.add("valid_offspring", num_valid_offspring);
+        run_stats.set("diversity_island_" + to_string(island), diversity(current, population_size));
+        total_generations += iteration;
+        total_offspring += num_offspring;
+        total_valid_offspring += num_valid_offspring;
+        num_offspring = num_valid_offspring = 0;
+    }
+
+    islands[island]->last_iteration = iteration;
+    islands[island]->finished.store(true, memory_order_release);
 }
 
 
-int main(int argc, char *argv[]) {
+/*
+ * Runs the genetic algorithm on num_islands islands, each one in its own thread and with its own random numbers,
+ * given by the seed (or taken at random if the seed is negative). Then it reports the gap of the best solution
+ * to an upper bound.
+ */
+void metaheuristica(uint num_islands, long long seed) {
+
+    deterministic = seed >= 0;
+    random_device rd;
+    vector<uint> seeds;
+    for (uint i = 0; i < num_islands; i++) seeds.push_back(deterministic ? uint(seed + i) : rd());
+
+    islands.clear();
+    for (uint i = 0; i < num_islands; i++) islands.push_back(make_unique<Island>());
+
+    if (num_islands == 1) {
+        run_island(0, seeds[0]);
+    }
+    else {
+        vector<thread> threads;
+        for (uint i = 0; i < num_islands; i++) threads.emplace_back(run_island, i, seeds[i]);
+        for (thread& t : threads) t.join();
+    }
+
+#ifdef COUNT_ALLOCATIONS
+    cerr << "Allocations in the iterations: " << iteration_allocations << endl;
+#endif
+
+    // if the deadline is reached before finding a valid solution, the greedy one is given
+    if (best_solution.size() < 11) {
+        PlayerList candidates;
+        for (Position pos : positions) {
+            candidates.insert(candidates.end(), players_map[pos].begin(), players_map[pos].end());
+        }
+        best_solution = Solution(greedy(candidates, greedy_alpha()));
+        writer->publish(best_solution);
+    }
+
+    int bound = knapsack_bound();
+    if (deadline->expired()) cerr << "Deadline reached" << endl;
+    if (best_solution.get_points() >= bound) cerr << "Upper bound: " << bound << " (optimal)" << endl;
+    else cerr << "Upper bound: " << bound << " (gap " << 100.0 * (bound - best_solution.get_points()) / max(bound, 1) << "%)" << endl;
+}
+
+
+// Options of the metaheuristic
+int write_interval = 100;
+int deadline_ms = 0; // no deadline
+uint num_islands = 1;
+long long seed = -1; // random seed
+
+
+// Solves the query of query_file and writes the best solution found in output_file
+void solve(CandidatePool& pool, const string& query_file, const string& output_file) {
 
     start_time = chrono::high_resolution_clock::now(); // start the timer
-    
-    string input_database = argv[1];
-    string input_query = argv[2];
-    output_file = argv[3];
+    run_stats.start_query(query_file);
+
+    ScopedTimer preprocess_timer(run_stats, "preprocess");
+    query = read_query(query_file);
+    read_players_map(pool);
+    preprocess_timer.stop();
+
+    writer = make_unique<SolutionWriter>(output_file, start_time, chrono::milliseconds(write_interval));
+    deadline = make_unique<Deadline>(start_time, chrono::milliseconds(deadline_ms));
+
+    best_solution = Solution();
+    best_island = 0;
+    best_points = 0;
+    total_generations = total_offspring = total_valid_offspring = 0;
+    ScopedTimer search_timer(run_stats, "search");
+    auto search_start = chrono::high_resolution_clock::now();
+    metaheuristica(num_islands, seed);
+    search_timer.stop();
+    deadline.reset();
+    double search_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - search_start).count();
+    run_stats.set("generations_per_s", total_generations / max(search_seconds, 1e-9));
+    run_stats.set("valid_offspring_ratio", double(total_valid_offspring) / max(total_offspring.load(), 1ll));
+
+    ScopedTimer write_timer(run_stats, "write");
+    writer->finish();
+    write_timer.stop();
+    run_stats.end_query();
+}
 
-    query = read_query(input_query);
-    Player::alpha = pow(query.max_cost / 1e7, 0.3);
 
-    read_players_map();
-    
-    metaheuristica(population_size);
-}
\ No newline at end of file
+/*
+ * mh <database> <query> <output> [options]
+ * mh <database> --batch <list> [options]: solves all the queries of the list, that has a query file and an output file
+ * in each line, reading the database only once
+ */
+int main(int argc, char *argv[]) {
+
+    string input_database = argv[1];
+    bool batch = argc > 2 and string(argv[2]).rfind("--", 0) == 0;
+
+    // optional arguments: --write-interval-ms <ms>, --deadline-ms <ms>, --islands <N>, --seed <seed>,
+    // --local-search <none|first|best>, --tabu <moves>, --stats <file>, --batch <list>
+    map<string, string> options = read_options(argc, argv, batch ? 2 : 4, {"write-interval-ms", "deadline-ms", "islands", "seed", "local-search", "tabu", "stats", "batch"});
+    if (options.count("write-interval-ms")) write_interval = stoi(options["write-interval-ms"]);
+    if (options.count("deadline-ms")) deadline_ms = stoi(options["deadline-ms"]);
+    if (options.count("islands")) num_islands = max(1, stoi(options["islands"]));
+    if (options.count("seed")) seed = stoll(options["seed"]);
+    if (options.count("local-search")) local_search = options["local-search"];
+    if (options.count("tabu")) tabu_tenure = stoi(options["tabu"]);
+
+    if (options.count("stats")) run_stats.open(options["stats"]);
+
+    ScopedTimer load_timer(run_stats, "load");
+    Database database(input_database);
+    CandidatePool pool(database);
+    load_timer.stop();
+
+    if (options.count("batch")) {
+        for (auto [query_file, output_file] : read_batch(options["batch"])) {
+            solve(pool, query_file, output_file);
+        }
+    }
+    else {
+        solve(pool, argv[2], argv[3]);
+    }
+}
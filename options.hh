@@ -0,0 +1,43 @@
+#ifndef OPTIONS_HH
+#define OPTIONS_HH
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/*
+ * Reads the optional arguments of a program, given after the mandatory ones as "--name value" or "--name=value",
+ * and returns their values by name (without the "--"). Exits with an error if an option isn't in the allowed ones.
+ * Options that don't take a value (like "--name") must be the last argument or be written as "--name=".
+ */
+inline map<string, string> read_options(int argc, char *argv[], int first, const vector<string>& allowed) {
+    map<string, string> options;
+    for (int i = first; i < argc; i++) {
+        string arg = argv[i], value;
+        size_t equal = arg.find('=');
+        if (equal != string::npos) {
+            value = arg.substr(equal + 1);
+            arg = arg.substr(0, equal);
+        }
+        else if (i + 1 < argc) {
+            value = argv[++i];
+        }
+
+        string name = arg.rfind("--", 0) == 0 ? arg.substr(2) : arg;
+        bool known = false;
+        for (const string& option : allowed) known = known or option == name;
+        if (not known) {
+            cerr << "Unknown option: " << arg << endl;
+            exit(1);
+        }
+        options[name] = value;
+    }
+    return options;
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef PLAYER_TABLE_HH
+#define PLAYER_TABLE_HH
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+
+enum class Position : uint8_t { por, def, mig, dav };
+
+const Position positions[] = {Position::por, Position::def, Position::mig, Position::dav}; // List of all the positions, in the order they are filled
+const string pos_names[] = {"por", "def", "mig", "dav"}; // name of each position in the database
+
+inline const string& pos_name(Position pos) {
+    return pos_names[uint8_t(pos)];
+}
+
+// Returns the position with the given name in the database
+inline Position to_position(string_view name) {
+    for (Position pos : positions) {
+        if (pos_name(pos) == name) return pos;
+    }
+    assert(false); // unknown position
+    return Position::por;
+}
+
+
+// Fixed-size array with one element for each position
+template <typename T>
+struct PerPosition
+{
+    T values[4];
+
+    T& operator[] (Position pos) { return values[uint8_t(pos)]; }
+    const T& operator[] (Position pos) const { return values[uint8_t(pos)]; }
+};
+
+
+using PlayerId = uint16_t; // index of a player in the PlayerTable
+using PlayerList = vector<PlayerId>; // vector of player ids
+using PlayerMap = PerPosition<PlayerList>; // players by position
+
+
+/*
+ * Stores the players added from the database (the candidates of the queries, see CandidatePool) as contiguous arrays
+ * indexed by their id.
+ * The names are interned once in a single buffer, so the solvers can work only with ids
+ * and never copy strings while searching.
+ */
+class PlayerTable
+{
+private:
+    string names; // all the names, one after the other
+    vector<uint32_t> name_start = {0}; // name of the player i is names[name_start[i], name_start[i+1])
+    vector<int> prices, points_;
+    vector<Position> positions_;
+
+public:
+
+    // Adds a player to the table and returns its id
+    PlayerId add(string_view name, Position pos, int price, int points) {
+        assert(size() < UINT16_MAX); // ids must fit in a PlayerId
+        names.append(name);
+        name_start.push_back(names.size());
+        prices.push_back(price);
+        points_.push_back(points);
+        positions_.push_back(pos);
+        return size() - 1;
+    }
+
+    string_view name(PlayerId id) const {
+        return string_view(names).substr(name_start[id], name_start[id + 1] - name_start[id]);
+    }
+
+    int price(PlayerId id) const { return prices[id]; }
+
+    int points(PlayerId id) const { return points_[id]; }
+
+    Position pos(PlayerId id) const { return positions_[id]; }
+
+    // Changes the price and points of a player
+    void update(PlayerId id, int price, int points) {
+        prices[id] = price;
+        points_[id] = points;
+    }
+
+    size_t size() const { return prices.size(); }
+};
+
+extern PlayerTable player_table; // the table of players used by the solver, defined by each program
+
+#endif
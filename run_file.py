@@ -26,7 +26,7 @@ def get_points(alg, diff, num, output_file='output.txt'):
 
 def compile_file(alg):
     try:
-        subprocess.run(["g++", alg+'.cc', "-o", alg, "-O3", "-Wall"], check=True)
+        subprocess.run(["g++", alg+'.cc', "-o", alg, "-std=c++17", "-O3", "-Wall", "-pthread"], check=True)
     
     except subprocess.CalledProcessError as e:
         print(f"Error compiling the file: {e}")
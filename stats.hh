@@ -0,0 +1,188 @@
+#ifndef STATS_HH
+#define STATS_HH
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+// Increments a counter of the search, unless the statistics are removed when compiling (with -DNO_STATS)
+#ifdef NO_STATS
+#define COUNT(counter)
+#else
+#define COUNT(counter) (counter)++
+#endif
+
+
+/*
+ * Statistics of the queries solved by a program, written to a file (with --stats <file>) as one JSON object per
+ * query and line:
+ *     {"query": "...", "phases_ms": {"load": ..., "preprocess": ..., "search": ..., "write": ...},
+ *      "counters": {...}, "values": {...}, "improvements": [{"ms": ..., "points": ...}, ...]}
+ * The phases are timed with ScopedTimer, the counters and values are given by the solver at the end of the search,
+ * and the improvements are the points of every new best solution and the time since the query started (time to
+ * incumbent). The database is loaded once, so the time of the load is only in the first query.
+ *
+ * Nothing is recorded if there is no file, so the solvers can always call it. Compiling with -DNO_STATS removes all
+ * of it (and the counters incremented with COUNT).
+ * The methods can be called from several threads.
+ */
+class Stats
+{
+private:
+    using Clock = chrono::steady_clock;
+
+    ofstream output;
+    string query_file;
+    Clock::time_point query_start = Clock::now();
+    vector<pair<string, double>> phases; // milliseconds of each phase, in the order they ended
+    vector<pair<string, long long>> counters;
+    vector<pair<string, double>> values;
+    vector<pair<double, int>> improvements; // milliseconds and points
+    mutex stats_mutex;
+
+public:
+
+    // Starts writing the statistics to a file
+    void open([[maybe_unused]] const string& file) {
+#ifdef NO_STATS
+        cerr << "The statistics were removed when compiling (with -DNO_STATS), --stats is ignored" << endl;
+#else
+        output.open(file);
+        if (not output) {
+            cerr << "Can't write the statistics in " << file << endl;
+            exit(1);
+        }
+#endif
+    }
+
+    bool enabled() const {
+#ifdef NO_STATS
+        return false;
+#else
+        return output.is_open();
+#endif
+    }
+
+    // Starts the statistics of a query, the times of the improvements are taken from now
+    void start_query(const string& file) {
+        if (not enabled()) return;
+        lock_guard<mutex> lock(stats_mutex);
+        query_file = file;
+        query_start = Clock::now();
+    }
+
+    // Adds time to a phase
+    void add_time(const string& phase, double ms) {
+        if (not enabled()) return;
+        lock_guard<mutex> lock(stats_mutex);
+        find(phases, phase) += ms;
+    }
+
+    // Adds to a counter (the counters of several threads are added up)
+    void add(const string& counter, long long value) {
+        if (not enabled()) return;
+        lock_guard<mutex> lock(stats_mutex);
+        find(counters, counter) += value;
+    }
+
+    // Sets a value that isn't a counter (a rate, a ratio...)
+    void set(const string& name, double value) {
+        if (not enabled()) return;
+        lock_guard<mutex> lock(stats_mutex);
+        find(values, name) = value;
+    }
+
+    // Records a new best solution of the query with the given points
+    void improvement(int points) {
+        if (not enabled()) return;
+        double ms = chrono::duration<double, milli>(Clock::now() - query_start).count();
+        lock_guard<mutex> lock(stats_mutex);
+        improvements.push_back({ms, points});
+    }
+
+    // Writes the statistics of the query in a line of the file, and clears them for the next query
+    void end_query() {
+        if (not enabled()) return;
+        lock_guard<mutex> lock(stats_mutex);
+        output << "{\"query\": \"" << escape(query_file) << "\", \"phases_ms\": {";
+        write_pairs(phases);
+        output << "}, \"counters\": {";
+        write_pairs(counters);
+        output << "}, \"values\": {";
+        write_pairs(values);
+        output << "}, \"improvements\": [";
+        for (uint i = 0; i < improvements.size(); i++) {
+            output << (i > 0 ? ", " : "") << "{\"ms\": " << improvements[i].first << ", \"points\": " << improvements[i].second << "}";
+        }
+        output << "]}" << endl;
+
+        phases.clear();
+        counters.clear();
+        values.clear();
+        improvements.clear();
+    }
+
+private:
+
+    template <typename T>
+    static T& find(vector<pair<string, T>>& pairs, const string& name) {
+        for (auto& [key, value] : pairs) {
+            if (key == name) return value;
+        }
+        pairs.push_back({name, T()});
+        return pairs.back().second;
+    }
+
+    template <typename T>
+    void write_pairs(const vector<pair<string, T>>& pairs) {
+        for (uint i = 0; i < pairs.size(); i++) {
+            output << (i > 0 ? ", " : "") << "\"" << escape(pairs[i].first) << "\": " << pairs[i].second;
+        }
+    }
+
+    static string escape(const string& text) {
+        string escaped;
+        for (char c : text) {
+            if (c == '"' or c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+
+/*
+ * Adds the time from its creation to its destruction (or to stop()) to a phase of the statistics.
+ */
+class ScopedTimer
+{
+private:
+    Stats& stats;
+    string phase;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool stopped = false;
+
+public:
+
+    ScopedTimer(Stats& stats, const string& phase) : stats(stats), phase(phase) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator= (const ScopedTimer&) = delete;
+
+    ~ScopedTimer() { stop(); }
+
+    void stop() {
+        if (stopped) return;
+        stopped = true;
+        stats.add_time(phase, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef WRITER_HH
+#define WRITER_HH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "lineup.hh"
+
+using namespace std;
+
+
+/*
+ * Writes the best solution found by a solver in the output file from a separate thread, so the search never waits
+ * for the disk. The search publishes every new best solution, and every interval the writer writes the newest one
+ * to a temporary file and renames it to the output file, so a reader never sees a half written file.
+ *
+ * The solutions are passed through a triple buffer: the search writes in its own buffer and swaps it with the
+ * middle one, and the writer swaps the middle one with its own buffer when there is a new solution, so neither
+ * of them ever waits for the other. publish() must not be called from several threads at the same time.
+ */
+class SolutionWriter
+{
+private:
+    struct Entry
+    {
+        Lineup lineup;
+        double seconds; // time since the start when the solution was found
+    };
+
+    static const uint8_t NEW = 4; // flag of middle telling that it has a solution not written yet
+
+    string output_file;
+    chrono::time_point<chrono::high_resolution_clock> start_time;
+    chrono::milliseconds interval;
+
+    Entry buffers[3];
+    uint8_t back = 0, front = 1; // buffers used by the search and the writer
+    atomic<uint8_t> middle = 2; // buffer exchanged between them, with the flag NEW
+
+    bool stopping = false;
+    mutex stop_mutex;
+    condition_variable stop_requested;
+    thread writer;
+
+public:
+
+    SolutionWriter(const string& output_file, chrono::time_point<chrono::high_resolution_clock> start_time, chrono::milliseconds interval)
+        : output_file(output_file), start_time(start_time), interval(interval) {
+        writer = thread(&SolutionWriter::run, this);
+    }
+
+    ~SolutionWriter() { finish(); }
+
+    // Publishes a new best solution, that will be written in the next interval
+    void publish(const Lineup& lineup) {
+        auto now = chrono::high_resolution_clock::now();
+        buffers[back] = {lineup, chrono::duration_cast<chrono::milliseconds>(now - start_time).count() / 1000.0};
+        back = middle.exchange(back | NEW) & ~NEW;
+    }
+
+    // Writes the last solution published and stops the writer thread
+    void finish() {
+        if (not writer.joinable()) return;
+        {
+            lock_guard<mutex> lock(stop_mutex);
+            stopping = true;
+        }
+        stop_requested.notify_one();
+        writer.join();
+    }
+
+private:
+
+    void run() {
+        unique_lock<mutex> lock(stop_mutex);
+        bool stop = false;
+        while (not stop) {
+            stop = stop_requested.wait_for(lock, interval, [this] { return stopping; });
+            if (middle.load() & NEW) {
+                front = middle.exchange(front) & ~NEW;
+                write(buffers[front]);
+            }
+        }
+    }
+
+    // Writes a solution in a temporary file and renames it to the output file
+    void write(const Entry& entry) const {
+        string temp_file = output_file + ".tmp";
+        ofstream output(temp_file);
+        output << fixed;
+        output.precision(1);
+        output << entry.seconds << endl;
+        entry.lineup.write(output);
+        output.close();
+
+        rename(temp_file.c_str(), output_file.c_str());
+    }
+};
+
+#endif